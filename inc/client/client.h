@@ -46,6 +46,7 @@ typedef struct {
 typedef struct {
     char map[MAX_QPATH];
     char pov[MAX_CLIENT_NAME];
+    int frames;     // 0 if unknown
     bool mvd;
 } demoInfo_t;
 
@@ -0,0 +1,37 @@
+/*
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef LOADPROF_H
+#define LOADPROF_H
+
+//
+// hierarchical profiler for level transitions
+//
+// Zones nest and are only recorded between LoadProf_BeginLevel and
+// LoadProf_EndLevel when com_loadprof is enabled. Zone names must point
+// to static strings, detail is copied.
+//
+
+void LoadProf_Init(void);
+void LoadProf_BeginLevel(const char *mapname);
+void LoadProf_EndLevel(void);
+void LoadProf_Abort(void);
+bool LoadProf_Active(void);
+
+void LoadProf_Begin(const char *name, const char *detail);
+void LoadProf_End(void);
+
+#endif // LOADPROF_H
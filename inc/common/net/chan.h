@@ -40,6 +40,8 @@ typedef struct netchan_s {
     int         dropped;            // between last packet and previous
     unsigned    total_dropped;      // for statistics
     unsigned    total_received;
+    unsigned    total_acked;        // outgoing packets acknowledged by remote
+    unsigned    total_skipped;      // outgoing packets remote ack jumped over
 
     unsigned    last_received;      // for timeouts
     unsigned    last_sent;          // for retransmits
@@ -92,7 +94,7 @@ typedef struct netchan_old_s {
 
     byte        *message_buf;       // leave space for header
 
-// message is copied to this buffer when it is first transfered
+// buffers are swapped when message is first transfered
     byte        *reliable_buf;  // unacked reliable message
 } netchan_old_t;
 
@@ -106,17 +108,30 @@ typedef struct netchan_new_s {
     int         last_reliable_sequence;     // sequence number of last send
     int         fragment_sequence;
 
-// reliable staging and holding areas
-    byte        message_buf[MAX_MSGLEN];        // leave space for header
+// reliable staging and holding areas, point into reliable_bufs
+    byte        *message_buf;       // leave space for header
 
-// message is copied to this buffer when it is first transfered
-    byte        reliable_buf[MAX_MSGLEN];   // unacked reliable message
+// buffers are swapped when message is first transfered
+    byte        *reliable_buf;  // unacked reliable message
 
-    sizebuf_t   fragment_in;
-    byte        fragment_in_buf[MAX_MSGLEN];
+    byte        reliable_bufs[2][MAX_MSGLEN];
 
-    sizebuf_t   fragment_out;
-    byte        fragment_out_buf[MAX_MSGLEN];
+// fragment buffers are taken from a shared pool only while in use
+    sizebuf_t   fragment_in;
+    sizebuf_t   fragment_out;       // unreliable part of fragmented message
+    size_t      fragment_reliable;  // reliable_buf bytes sent ahead of fragment_out
 } netchan_new_t;
 
+// statistics for net_stats
+typedef struct {
+    uint64_t    fragments_sent;
+    uint64_t    fragments_rcvd;
+    uint64_t    fragments_dropped;
+    uint64_t    messages_fragmented;
+    uint64_t    messages_reassembled;
+    uint64_t    reliable_resends;
+} netchan_stats_t;
+
+extern netchan_stats_t  netchan_stats;
+
 #endif // NET_CHAN_H
@@ -95,6 +95,14 @@ typedef struct netadr_s {
     uint32_t scope_id;  // IPv6 crap
 } netadr_t;
 
+// packet is sent as a concatenation of these, without copying
+typedef struct {
+    const void  *data;
+    size_t      len;
+} net_iovec_t;
+
+#define NET_MAX_IOVECS  4
+
 typedef enum netstate_e {
     NS_DISCONNECTED,// no socket opened
     NS_CONNECTING,  // connect() not yet completed
@@ -238,6 +246,8 @@ bool        NET_GetAddress(netsrc_t sock, netadr_t *adr);
 void        NET_GetPackets(netsrc_t sock, void (*packet_cb)(void));
 bool        NET_SendPacket(netsrc_t sock, const void *data,
                            size_t len, const netadr_t *to);
+bool        NET_SendPacketv(netsrc_t sock, const net_iovec_t *iov,
+                            int iovcnt, const netadr_t *to);
 
 char        *NET_AdrToString(const netadr_t *a);
 bool        NET_StringToAdr(const char *s, netadr_t *a, int default_port);
@@ -54,6 +54,7 @@ char    *Z_TagCopyString(const char *in, memtag_t tag) q_malloc;
 void    Z_FreeTags(memtag_t tag);
 void    Z_LeakTest(memtag_t tag);
 void    Z_Stats_f(void);
+size_t  Z_AllocCount(void);
 
 void    Z_TagReserve(size_t size, memtag_t tag);
 void    *Z_ReservedAlloc(size_t size) q_malloc;
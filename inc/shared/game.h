@@ -199,6 +199,11 @@ typedef struct {
         int accuracy, char time_string[static SPEEDRUN_TIME_LENGTH]);
     void (*SpeedrunGetLevelTimeString)(
         int accuracy, char time_string[static SPEEDRUN_TIME_LENGTH]);
+
+    // monotonic time for profiling
+    uint64_t (*Microseconds)(void);
+
+    void (*SpeedrunRunFinished)(void);
 } game_import_t;
 
 //
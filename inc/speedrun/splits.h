@@ -0,0 +1,18 @@
+#pragma once
+
+#include "speedrun/timer.h"
+
+
+// sign followed by a time string
+#define SPEEDRUN_DELTA_LENGTH (SPEEDRUN_TIME_LENGTH + 1)
+
+void SpeedrunSplitsInit();
+void SpeedrunSplitsReset();
+void SpeedrunSplitsStartLevel(const char *mapname);
+void SpeedrunSplitsLevelFinished(uint64_t segment, uint64_t total);
+void SpeedrunSplitsRunFinished();
+
+// Returns the delta against the personal best to show on the HUD, or NULL if
+// there is nothing to compare against. The string is cached and only
+// reformatted when the displayed value changes.
+const char *SpeedrunGetSplitDelta(bool *behind);
@@ -5,13 +5,33 @@
 
 #define SPEEDRUN_TIME_LENGTH 13
 
+// Load phases are timed as separate intervals so that they can be removed
+// from the run exactly. Phases may overlap; overlapping time is only counted
+// once towards the total load time.
+typedef enum
+{
+	SPEEDRUN_LOAD_MAP,
+	SPEEDRUN_LOAD_PRECACHE,
+	SPEEDRUN_LOAD_SAVEGAME,
+	SPEEDRUN_LOAD_REGISTRATION,
+
+	SPEEDRUN_LOAD_MAX
+} speedrun_load_t;
+
+void SpeedrunInitTimer();
 void SpeedrunResetTimer();
-void SpeedrunUpdateTimer();
 void SpeedrunTimerAddMilliseconds(int msec);
 void SpeedrunUnpauseTimer();
 int SpeedrunPauseTimer();
 void SpeedrunLevelFinished();
+void SpeedrunBeginLoad(speedrun_load_t phase);
+void SpeedrunEndLoad(speedrun_load_t phase);
+void SpeedrunAbortLoad();
+uint64_t SpeedrunGetTotalTime();
+uint64_t SpeedrunGetLevelTime();
 void SpeedrunGetTotalTimeString(int accuracy,
                                 char time_string[static SPEEDRUN_TIME_LENGTH]);
 void SpeedrunGetLevelTimeString(int accuracy,
                                 char time_string[static SPEEDRUN_TIME_LENGTH]);
+void SpeedrunGetTimeString(int milliseconds, int accuracy,
+                           char time_string[static SPEEDRUN_TIME_LENGTH]);
@@ -360,7 +360,7 @@ void FoundTarget(edict_t *self)
     self->monsterinfo.aiflags |= AI_COMBAT_POINT;
 
     // clear the targetname, that point is ours!
-    self->movetarget->targetname = NULL;
+    G_SetTargetname(self->movetarget, NULL);
     self->monsterinfo.pausetime = 0;
 
     // run for it
@@ -463,10 +463,8 @@ bool FindTarget(edict_t *self)
         if (client->light_level <= 5)
             return false;
 
-        if (!visible(self, client)) {
-            return false;
-        }
-
+        // facing checks are cheap and have no side effects, so do them
+        // before tracing. result is the same as in original order.
         if (r == RANGE_NEAR) {
             if (client->show_hostile < level.time && !infront(self, client)) {
                 return false;
@@ -477,6 +475,10 @@ bool FindTarget(edict_t *self)
             }
         }
 
+        if (!visible(self, client)) {
+            return false;
+        }
+
         self->enemy = client;
 
         if (strcmp(self->enemy->classname, "player_noise") != 0) {
@@ -493,14 +495,7 @@ bool FindTarget(edict_t *self)
     } else { // heardit
         vec3_t  temp;
 
-        if (self->spawnflags & 1) {
-            if (!visible(self, client))
-                return false;
-        } else {
-            if (!gi.inPHS(self->s.origin, client->s.origin))
-                return false;
-        }
-
+        // reject by distance and areas before doing PHS or trace checks
         VectorSubtract(client->s.origin, self->s.origin, temp);
 
         if (VectorLength(temp) > 1000) { // too far to hear
@@ -512,6 +507,14 @@ bool FindTarget(edict_t *self)
             if (!gi.AreasConnected(self->areanum, client->areanum))
                 return false;
 
+        if (self->spawnflags & 1) {
+            if (!visible(self, client))
+                return false;
+        } else {
+            if (!gi.inPHS(self->s.origin, client->s.origin))
+                return false;
+        }
+
         self->ideal_yaw = vectoyaw(temp);
         M_ChangeYaw(self);
 
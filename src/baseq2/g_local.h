@@ -543,6 +543,9 @@ extern  cvar_t  *sv_maplist;
 
 extern  cvar_t  *sv_features;
 
+extern  cvar_t  *g_profile;
+extern  cvar_t  *g_seed;
+
 #define world   (&g_edicts[0])
 
 // item spawnflags
@@ -578,6 +581,14 @@ typedef enum {
     F_IGNORE
 } fieldtype_t;
 
+// entity fields hashed for fast G_Find lookups
+typedef enum {
+    EDICT_INDEX_CLASSNAME,
+    EDICT_INDEX_TARGETNAME,
+
+    EDICT_INDEX_MAX
+} edict_index_t;
+
 extern  gitem_t itemlist[];
 
 //
@@ -621,6 +632,12 @@ void    G_InitEdict(edict_t *e);
 edict_t *G_Spawn(void);
 void    G_FreeEdict(edict_t *e);
 
+void    G_SetClassname(edict_t *ent, char *classname);
+void    G_SetTargetname(edict_t *ent, char *targetname);
+void    G_UnlinkEdictIndex(edict_t *ent);
+void    G_ClearEdictIndex(void);
+void    G_RebuildEdictIndex(void);
+
 void    G_TouchTriggers(edict_t *ent);
 void    G_TouchSolids(edict_t *ent);
 
@@ -726,11 +743,11 @@ void fire_bfg(edict_t *self, vec3_t start, vec3_t dir, int damage, int speed, fl
 // g_ptrail.c
 //
 void PlayerTrail_Init(void);
-void PlayerTrail_Add(vec3_t spot);
-void PlayerTrail_New(vec3_t spot);
+void PlayerTrail_Add(edict_t *ent, vec3_t spot);
+void PlayerTrail_New(edict_t *ent, vec3_t spot);
 edict_t *PlayerTrail_PickFirst(edict_t *self);
 edict_t *PlayerTrail_PickNext(edict_t *self);
-edict_t *PlayerTrail_LastSpot(void);
+edict_t *PlayerTrail_LastSpot(edict_t *ent);
 
 //
 // g_client.c
@@ -788,6 +805,14 @@ void M_ChangeYaw(edict_t *ent);
 //
 void G_RunEntity(edict_t *ent);
 
+//
+// g_prof.c
+//
+void G_ProfileFrame(void);
+void G_ProfileRunThink(edict_t *ent);
+void G_ProfileRunEntity(edict_t *ent);
+void Svcmd_GameProf_f(void);
+
 //
 // g_main.c
 //
@@ -1090,6 +1115,11 @@ struct edict_s {
 
     gitem_t     *item;          // for bonus items
 
+    // classname/targetname hash chains, maintained by G_SetClassname
+    // and G_SetTargetname, never saved
+    edict_t     *index_next[EDICT_INDEX_MAX];
+    unsigned    index_hash[EDICT_INDEX_MAX];    // bucket + 1, 0 if not linked
+
     // common data blocks
     moveinfo_t      moveinfo;
     monsterinfo_t   monsterinfo;
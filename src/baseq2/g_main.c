@@ -72,6 +72,9 @@ cvar_t  *sv_maplist;
 
 cvar_t  *sv_features;
 
+cvar_t  *g_profile;
+cvar_t  *g_seed;
+
 void SpawnEntities(const char *mapname, const char *entities, const char *spawnpoint);
 void ClientThink(edict_t *ent, usercmd_t *cmd);
 qboolean ClientConnect(edict_t *ent, char *userinfo);
@@ -167,6 +170,9 @@ void InitGame(void)
     // obtain server features
     sv_features = gi.cvar("sv_features", NULL, 0);
 
+    g_profile = gi.cvar("g_profile", "0", 0);
+    g_seed = gi.cvar("g_seed", "0", 0);
+
     // export our own features
     gi.cvar_forceset("g_features", va("%d", G_FEATURES));
 
@@ -295,7 +301,7 @@ edict_t *CreateTargetChangeLevel(char *map)
     edict_t *ent;
 
     ent = G_Spawn();
-    ent->classname = "target_changelevel";
+    G_SetClassname(ent, "target_changelevel");
     Q_snprintf(level.nextmap, sizeof(level.nextmap), "%s", map);
     ent->map = level.nextmap;
     return ent;
@@ -473,6 +479,9 @@ void G_RunFrame(bool is_frame_timed_speedrun)
         gi.SpeedrunTimerAddMilliseconds(FRAMETIME * 1000);
     }
 
+    if (g_profile->integer)
+        G_ProfileFrame();
+
     // choose a client for monsters to target this frame
     AI_SetSightClient();
 
@@ -509,7 +518,10 @@ void G_RunFrame(bool is_frame_timed_speedrun)
             continue;
         }
 
-        G_RunEntity(ent);
+        if (g_profile->integer)
+            G_ProfileRunEntity(ent);
+        else
+            G_RunEntity(ent);
     }
 
     // see if it is time to end a deathmatch
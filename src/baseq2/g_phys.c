@@ -102,7 +102,10 @@ bool SV_RunThink(edict_t *ent)
     ent->nextthink = 0;
     if (!ent->think)
         gi.error("NULL ent->think");
-    ent->think(ent);
+    if (g_profile->integer)
+        G_ProfileRunThink(ent);
+    else
+        ent->think(ent);
 
     return false;
 }
@@ -0,0 +1,192 @@
+// g_prof.c -- per think function and movetype frame profiling
+
+#include "g_local.h"
+#include "g_ptrs.h"
+
+#define PROF_HASH_SIZE  1024    // must be power of two
+
+typedef struct {
+    void        *func;
+    uint64_t    time;
+    unsigned    calls;
+} prof_entry_t;
+
+static prof_entry_t prof_think[PROF_HASH_SIZE];
+static prof_entry_t prof_movetype[MOVETYPE_BOUNCE + 1];
+static prof_entry_t prof_overflow;
+static unsigned     prof_frames;
+
+static const char *const movetype_names[MOVETYPE_BOUNCE + 1] = {
+    "MOVETYPE_NONE",
+    "MOVETYPE_NOCLIP",
+    "MOVETYPE_PUSH",
+    "MOVETYPE_STOP",
+    "MOVETYPE_WALK",
+    "MOVETYPE_STEP",
+    "MOVETYPE_FLY",
+    "MOVETYPE_TOSS",
+    "MOVETYPE_FLYMISSILE",
+    "MOVETYPE_BOUNCE"
+};
+
+static prof_entry_t *G_ProfileThinkEntry(void *func)
+{
+    unsigned        hash = ((size_t)func >> 4) & (PROF_HASH_SIZE - 1);
+    prof_entry_t    *e;
+    int             i;
+
+    for (i = 0; i < PROF_HASH_SIZE; i++) {
+        e = &prof_think[(hash + i) & (PROF_HASH_SIZE - 1)];
+        if (e->func == func)
+            return e;
+        if (!e->func) {
+            e->func = func;
+            return e;
+        }
+    }
+
+    return &prof_overflow;
+}
+
+/*
+=============
+G_ProfileFrame
+
+Called once per frame when g_profile is enabled.
+=============
+*/
+void G_ProfileFrame(void)
+{
+    prof_frames++;
+}
+
+/*
+=============
+G_ProfileRunThink
+
+Timed replacement for ent->think(ent). Entity may be freed by the
+think function, so everything is sampled before calling it.
+=============
+*/
+void G_ProfileRunThink(edict_t *ent)
+{
+    void        (*think)(edict_t *) = ent->think;
+    uint64_t    start = gi.Microseconds();
+    prof_entry_t *e;
+
+    think(ent);
+
+    e = G_ProfileThinkEntry((void *)think);
+    e->time += gi.Microseconds() - start;
+    e->calls++;
+}
+
+/*
+=============
+G_ProfileRunEntity
+
+Timed replacement for G_RunEntity. Includes think time.
+=============
+*/
+void G_ProfileRunEntity(edict_t *ent)
+{
+    int         movetype = ent->movetype;
+    uint64_t    start = gi.Microseconds();
+    prof_entry_t *e;
+
+    G_RunEntity(ent);
+
+    if (movetype < 0 || movetype > MOVETYPE_BOUNCE)
+        return;
+
+    e = &prof_movetype[movetype];
+    e->time += gi.Microseconds() - start;
+    e->calls++;
+}
+
+static const char *G_ProfileThinkName(void *func)
+{
+    static char buffer[32];
+    const save_ptr_t *ptr;
+    int i;
+
+    if (!func)
+        return "<overflow>";
+
+    for (i = 0, ptr = save_ptrs; i < num_save_ptrs; i++, ptr++)
+        if (ptr->type == P_think && ptr->ptr == func)
+            return ptr->name;
+
+    Q_snprintf(buffer, sizeof(buffer), "%p", func);
+    return buffer;
+}
+
+static int G_ProfileCmp(const void *p1, const void *p2)
+{
+    const prof_entry_t *a = *(const prof_entry_t **)p1;
+    const prof_entry_t *b = *(const prof_entry_t **)p2;
+
+    if (a->time > b->time)
+        return -1;
+    if (a->time < b->time)
+        return 1;
+    return 0;
+}
+
+static void G_ProfilePrint(const prof_entry_t *e, const char *name)
+{
+    gi.cprintf(NULL, PRINT_HIGH, "%-32s %9u %9.2f %9.2f %9.2f\n", name, e->calls,
+               e->time * 1e-3, (double)e->time / prof_frames,
+               (double)e->time / e->calls);
+}
+
+/*
+=================
+Svcmd_GameProf_f
+
+sv gameprof [reset]
+=================
+*/
+void Svcmd_GameProf_f(void)
+{
+    prof_entry_t    *sorted[PROF_HASH_SIZE + 1];
+    int             i, count;
+
+    if (gi.argc() > 2 && !Q_stricmp(gi.argv(2), "reset")) {
+        memset(prof_think, 0, sizeof(prof_think));
+        memset(prof_movetype, 0, sizeof(prof_movetype));
+        memset(&prof_overflow, 0, sizeof(prof_overflow));
+        prof_frames = 0;
+        gi.cprintf(NULL, PRINT_HIGH, "Game profile reset.\n");
+        return;
+    }
+
+    if (!prof_frames) {
+        gi.cprintf(NULL, PRINT_HIGH, "No profile data. Set g_profile to 1 to collect.\n");
+        return;
+    }
+
+    gi.cprintf(NULL, PRINT_HIGH, "%u frames profiled.\n\n", prof_frames);
+
+    gi.cprintf(NULL, PRINT_HIGH,
+               "movetype                             calls      msec  usec/frm usec/call\n"
+               "-------------------------------- --------- --------- --------- ---------\n");
+    for (i = 0; i <= MOVETYPE_BOUNCE; i++)
+        if (prof_movetype[i].calls)
+            G_ProfilePrint(&prof_movetype[i], movetype_names[i]);
+
+    count = 0;
+    for (i = 0; i < PROF_HASH_SIZE; i++)
+        if (prof_think[i].calls)
+            sorted[count++] = &prof_think[i];
+    if (prof_overflow.calls)
+        sorted[count++] = &prof_overflow;
+
+    qsort(sorted, count, sizeof(sorted[0]), G_ProfileCmp);
+
+    gi.cprintf(NULL, PRINT_HIGH, "\n"
+               "think                                calls      msec  usec/frm usec/call\n"
+               "-------------------------------- --------- --------- --------- ---------\n");
+    for (i = 0; i < count; i++)
+        G_ProfilePrint(sorted[i], G_ProfileThinkName(sorted[i]->func));
+}
@@ -27,6 +27,7 @@ typedef enum {
 typedef struct {
     ptr_type_t type;
     void *ptr;
+    const char *name;
 } save_ptr_t;
 
 extern const save_ptr_t save_ptrs[];
@@ -858,6 +858,7 @@ void ReadGame(const char *filename)
     g_edicts = gi.TagMalloc(game.maxentities * sizeof(g_edicts[0]), TAG_GAME);
     globals.edicts = g_edicts;
     globals.max_edicts = game.maxentities;
+    G_ClearEdictIndex();
 
     game.clients = gi.TagMalloc(game.maxclients * sizeof(game.clients[0]), TAG_GAME);
     for (i = 0; i < game.maxclients; i++) {
@@ -980,6 +981,8 @@ void ReadLevel(const char *filename)
 
     fclose(f);
 
+    G_RebuildEdictIndex();
+
     // mark all clients as unconnected
     for (i = 0 ; i < maxclients->value ; i++) {
         ent = &g_edicts[i + 1];
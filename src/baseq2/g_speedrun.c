@@ -50,6 +50,7 @@ void CheckSpeedrunFinished(const gclient_t *client)
     {
         gi.SpeedrunLevelFinished();
         gi.SpeedrunPauseTimer();
+        gi.SpeedrunRunFinished();
         PrintSpeedrunTimer();
         speedrun_finished = true;
     }
@@ -28,6 +28,163 @@ void G_ProjectSource(const vec3_t point, const vec3_t distance, const vec3_t for
 }
 
 
+/*
+==============================================================================
+
+Entity lookup index
+
+Inuse entities are hashed by classname and targetname so that G_Find
+doesn't have to string compare every edict. Hash chains are kept sorted
+by entity number to preserve G_Find iteration order. These fields must
+only be modified through G_SetClassname and G_SetTargetname.
+
+==============================================================================
+*/
+
+#define EDICT_HASH_SIZE 1024
+
+static edict_t  *edict_hash[EDICT_INDEX_MAX][EDICT_HASH_SIZE];
+
+static unsigned G_HashName(const char *s)
+{
+    unsigned hash = 0;
+
+    while (*s)
+        hash = hash * 31 + Q_tolower(*s++);
+
+    return hash & (EDICT_HASH_SIZE - 1);
+}
+
+static void G_UnlinkIndex(edict_t *ent, edict_index_t index)
+{
+    edict_t **p;
+
+    if (!ent->index_hash[index])
+        return;
+
+    for (p = &edict_hash[index][ent->index_hash[index] - 1]; *p; p = &(*p)->index_next[index]) {
+        if (*p == ent) {
+            *p = ent->index_next[index];
+            break;
+        }
+    }
+
+    ent->index_next[index] = NULL;
+    ent->index_hash[index] = 0;
+}
+
+static void G_LinkIndex(edict_t *ent, edict_index_t index, const char *name)
+{
+    edict_t **p;
+    unsigned hash;
+
+    G_UnlinkIndex(ent, index);
+
+    if (!name)
+        return;
+
+    hash = G_HashName(name);
+    for (p = &edict_hash[index][hash]; *p && *p < ent; p = &(*p)->index_next[index])
+        ;
+
+    ent->index_next[index] = *p;
+    ent->index_hash[index] = hash + 1;
+    *p = ent;
+}
+
+void G_SetClassname(edict_t *ent, char *classname)
+{
+    ent->classname = classname;
+    G_LinkIndex(ent, EDICT_INDEX_CLASSNAME, classname);
+}
+
+void G_SetTargetname(edict_t *ent, char *targetname)
+{
+    ent->targetname = targetname;
+    G_LinkIndex(ent, EDICT_INDEX_TARGETNAME, targetname);
+}
+
+/*
+=============
+G_UnlinkEdictIndex
+
+Must be called before edict is wiped.
+=============
+*/
+void G_UnlinkEdictIndex(edict_t *ent)
+{
+    G_UnlinkIndex(ent, EDICT_INDEX_CLASSNAME);
+    G_UnlinkIndex(ent, EDICT_INDEX_TARGETNAME);
+}
+
+/*
+=============
+G_ClearEdictIndex
+
+Called after all edicts have been wiped.
+=============
+*/
+void G_ClearEdictIndex(void)
+{
+    memset(edict_hash, 0, sizeof(edict_hash));
+}
+
+/*
+=============
+G_RebuildEdictIndex
+
+Called after edicts have been loaded from a savegame.
+=============
+*/
+void G_RebuildEdictIndex(void)
+{
+    edict_t *ent;
+    int     i;
+
+    G_ClearEdictIndex();
+
+    for (i = 0, ent = g_edicts; i < globals.num_edicts; i++, ent++) {
+        ent->index_next[EDICT_INDEX_CLASSNAME] = NULL;
+        ent->index_next[EDICT_INDEX_TARGETNAME] = NULL;
+        ent->index_hash[EDICT_INDEX_CLASSNAME] = 0;
+        ent->index_hash[EDICT_INDEX_TARGETNAME] = 0;
+        if (!ent->inuse)
+            continue;
+        G_LinkIndex(ent, EDICT_INDEX_CLASSNAME, ent->classname);
+        G_LinkIndex(ent, EDICT_INDEX_TARGETNAME, ent->targetname);
+    }
+}
+
+static edict_t *G_FindIndexed(edict_t *from, edict_index_t index, int fieldofs, const char *match)
+{
+    unsigned    hash = G_HashName(match) + 1;
+    edict_t     *ent;
+    char        *s;
+
+    // continue from the previous match if it is still in this chain
+    if (from && from->index_hash[index] == hash) {
+        ent = from->index_next[index];
+    } else {
+        ent = edict_hash[index][hash - 1];
+        if (from)
+            while (ent && ent <= from)
+                ent = ent->index_next[index];
+    }
+
+    for (; ent; ent = ent->index_next[index]) {
+        if (!ent->inuse)
+            continue;
+        s = *(char **)((byte *)ent + fieldofs);
+        if (!s)
+            continue;
+        if (!Q_stricmp(s, match))
+            return ent;
+    }
+
+    return NULL;
+}
+
+
 /*
 =============
 G_Find
@@ -38,12 +195,18 @@ the matching string at fieldofs (use the FOFS() macro) in the structure.
 Searches beginning at the edict after from, or the beginning if NULL
 NULL will be returned if the end of the list is reached.
 
+Classname and targetname searches go through the hashed index.
 =============
 */
 edict_t *G_Find(edict_t *from, int fieldofs, char *match)
 {
     char    *s;
 
+    if (fieldofs == FOFS(classname))
+        return G_FindIndexed(from, EDICT_INDEX_CLASSNAME, fieldofs, match);
+    if (fieldofs == FOFS(targetname))
+        return G_FindIndexed(from, EDICT_INDEX_TARGETNAME, fieldofs, match);
+
     if (!from)
         from = g_edicts;
     else
@@ -173,7 +336,7 @@ void G_UseTargets(edict_t *ent, edict_t *activator)
     if (ent->delay) {
         // create a temp object to fire at a later time
         t = G_Spawn();
-        t->classname = "DelayedUse";
+        G_SetClassname(t, "DelayedUse");
         t->nextthink = level.time + ent->delay;
         t->think = Think_Delay;
         t->activator = activator;
@@ -372,7 +535,7 @@ char *G_CopyString(char *in)
 void G_InitEdict(edict_t *e)
 {
     e->inuse = true;
-    e->classname = "noclass";
+    G_SetClassname(e, "noclass");
     e->gravity = 1.0f;
     e->s.number = e - g_edicts;
 }
@@ -427,6 +590,7 @@ void G_FreeEdict(edict_t *ed)
         return;
     }
 
+    G_UnlinkEdictIndex(ed);
     memset(ed, 0, sizeof(*ed));
     ed->classname = "freed";
     ed->freetime = level.time;
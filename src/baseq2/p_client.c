@@ -52,7 +52,7 @@ void SP_FixCoopSpots(edict_t *self)
         if (VectorLength(d) < 384) {
             if ((!self->targetname) || Q_stricmp(self->targetname, spot->targetname) != 0) {
 //              gi.dprintf("FixCoopSpots changed %s at %s targetname from %s to %s\n", self->classname, vtos(self->s.origin), self->targetname, spot->targetname);
-                self->targetname = spot->targetname;
+                G_SetTargetname(self, spot->targetname);
             }
             return;
         }
@@ -69,27 +69,27 @@ void SP_CreateCoopSpots(edict_t *self)
 
     if (Q_stricmp(level.mapname, "security") == 0) {
         spot = G_Spawn();
-        spot->classname = "info_player_coop";
+        G_SetClassname(spot, "info_player_coop");
         spot->s.origin[0] = 188 - 64;
         spot->s.origin[1] = -164;
         spot->s.origin[2] = 80;
-        spot->targetname = "jail3";
+        G_SetTargetname(spot, "jail3");
         spot->s.angles[1] = 90;
 
         spot = G_Spawn();
-        spot->classname = "info_player_coop";
+        G_SetClassname(spot, "info_player_coop");
         spot->s.origin[0] = 188 + 64;
         spot->s.origin[1] = -164;
         spot->s.origin[2] = 80;
-        spot->targetname = "jail3";
+        G_SetTargetname(spot, "jail3");
         spot->s.angles[1] = 90;
 
         spot = G_Spawn();
-        spot->classname = "info_player_coop";
+        G_SetClassname(spot, "info_player_coop");
         spot->s.origin[0] = 188 + 128;
         spot->s.origin[1] = -164;
         spot->s.origin[2] = 80;
-        spot->targetname = "jail3";
+        G_SetTargetname(spot, "jail3");
         spot->s.angles[1] = 90;
 
         return;
@@ -875,7 +875,7 @@ void InitBodyQue(void)
     level.body_que = 0;
     for (i = 0; i < BODY_QUEUE_SIZE ; i++) {
         ent = G_Spawn();
-        ent->classname = "bodyque";
+        G_SetClassname(ent, "bodyque");
     }
 }
 
@@ -1120,7 +1120,7 @@ void PutClientInServer(edict_t *ent)
     ent->movetype = MOVETYPE_WALK;
     ent->viewheight = 22;
     ent->inuse = true;
-    ent->classname = "player";
+    G_SetClassname(ent, "player");
     ent->mass = 200;
     ent->solid = SOLID_BBOX;
     ent->deadflag = DEAD_NO;
@@ -1274,7 +1274,7 @@ void ClientBegin(edict_t *ent)
         // except for the persistant data that was initialized at
         // ClientConnect() time
         G_InitEdict(ent);
-        ent->classname = "player";
+        G_SetClassname(ent, "player");
         InitClientResp(ent->client);
         PutClientInServer(ent);
     }
@@ -1468,7 +1468,7 @@ void ClientDisconnect(edict_t *ent)
     ent->s.effects = 0;
     ent->solid = SOLID_NOT;
     ent->inuse = false;
-    ent->classname = "disconnected";
+    G_SetClassname(ent, "disconnected");
     ent->client->pers.connected = false;
 
     // FIXME: don't break skins on corpses, etc
@@ -1736,8 +1736,8 @@ void ClientBeginServerFrame(edict_t *ent)
 
     // add player trail so monsters can follow
     if (!deathmatch->value)
-        if (!visible(ent, PlayerTrail_LastSpot()))
-            PlayerTrail_Add(ent->s.old_origin);
+        if (!visible(ent, PlayerTrail_LastSpot(ent)))
+            PlayerTrail_Add(ent, ent->s.old_origin);
 
     client->latched_buttons = 0;
 }
@@ -28,6 +28,11 @@ PLAYER TRAIL
 This is a circular list containing the a list of points of where
 the player has been recently.  It is used by monsters for pursuit.
 
+Each client has its own trail, so that in coop monsters follow the
+player they lost sight of instead of a trail shared by everyone.
+Markers of a client are spawned when its trail is first used, so empty
+client slots don't take up edicts.
+
 .origin     the spot
 .owner      forward link
 .aiment     backward link
@@ -36,9 +41,9 @@ the player has been recently.  It is used by monsters for pursuit.
 
 #define TRAIL_LENGTH    8
 
-edict_t     *trail[TRAIL_LENGTH];
-int         trail_head;
-bool        trail_active = false;
+static edict_t  *trail[MAX_CLIENTS][TRAIL_LENGTH];
+static int      trail_head[MAX_CLIENTS];
+static bool     trail_active = false;
 
 #define NEXT(n)     (((n) + 1) & (TRAIL_LENGTH - 1))
 #define PREV(n)     (((n) - 1) & (TRAIL_LENGTH - 1))
@@ -46,94 +51,167 @@ bool        trail_active = false;
 
 void PlayerTrail_Init(void)
 {
-    int     n;
-
-    if (deathmatch->value /* FIXME || coop */)
+    if (deathmatch->value)
         return;
 
-    for (n = 0; n < TRAIL_LENGTH; n++) {
-        trail[n] = G_Spawn();
-        trail[n]->classname = "player_trail";
-    }
+    // edicts of the previous level are gone
+    memset(trail, 0, sizeof(trail));
+    memset(trail_head, 0, sizeof(trail_head));
 
-    trail_head = 0;
     trail_active = true;
 }
 
 
-void PlayerTrail_Add(vec3_t spot)
+// returns trail number of the given client
+static int PlayerTrail_ClientNum(edict_t *ent)
+{
+    int     num = ent - g_edicts - 1;
+
+    if (num < 0 || num >= game.maxclients)
+        return 0;
+    return num;
+}
+
+// spawns markers of the given trail if not done yet
+static edict_t **PlayerTrail_Spawn(int num)
+{
+    int     n;
+
+    if (!trail[num][0]) {
+        for (n = 0; n < TRAIL_LENGTH; n++) {
+            trail[num][n] = G_Spawn();
+            G_SetClassname(trail[num][n], "player_trail");
+        }
+        trail_head[num] = 0;
+    }
+
+    return trail[num];
+}
+
+// returns trail number of the client monster is hunting
+static int PlayerTrail_EnemyNum(edict_t *self)
+{
+    edict_t *enemy = self->enemy;
+
+    // player noise entities are owned by the client that made them
+    if (enemy && !enemy->client && enemy->owner)
+        enemy = enemy->owner;
+
+    if (enemy && enemy->client)
+        return PlayerTrail_ClientNum(enemy);
+    return 0;
+}
+
+
+void PlayerTrail_Add(edict_t *ent, vec3_t spot)
 {
     vec3_t  temp;
+    int     num;
+    edict_t **t;
 
     if (!trail_active)
         return;
 
-    VectorCopy(spot, trail[trail_head]->s.origin);
+    num = PlayerTrail_ClientNum(ent);
+    t = PlayerTrail_Spawn(num);
 
-    trail[trail_head]->timestamp = level.time;
+    VectorCopy(spot, t[trail_head[num]]->s.origin);
 
-    VectorSubtract(spot, trail[PREV(trail_head)]->s.origin, temp);
-    trail[trail_head]->s.angles[1] = vectoyaw(temp);
+    t[trail_head[num]]->timestamp = level.time;
 
-    trail_head = NEXT(trail_head);
+    VectorSubtract(spot, t[PREV(trail_head[num])]->s.origin, temp);
+    t[trail_head[num]]->s.angles[1] = vectoyaw(temp);
+
+    trail_head[num] = NEXT(trail_head[num]);
 }
 
 
-void PlayerTrail_New(vec3_t spot)
+void PlayerTrail_New(edict_t *ent, vec3_t spot)
 {
+    int     num, n;
+
     if (!trail_active)
         return;
 
-    PlayerTrail_Init();
-    PlayerTrail_Add(spot);
+    num = PlayerTrail_ClientNum(ent);
+    PlayerTrail_Spawn(num);
+    for (n = 0; n < TRAIL_LENGTH; n++)
+        trail[num][n]->timestamp = 0;
+    trail_head[num] = 0;
+
+    PlayerTrail_Add(ent, spot);
+}
+
+
+/*
+=============
+PlayerTrail_Marker
+
+Returns the oldest marker newer than the monster's trail time, or the
+oldest marker if there is none. Timestamps never decrease going from
+the head around the ring, so this is a binary search.
+=============
+*/
+static int PlayerTrail_Marker(edict_t *self, int num)
+{
+    int     lo, hi, mid;
+
+    lo = 0;
+    hi = TRAIL_LENGTH;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (trail[num][(trail_head[num] + mid) & (TRAIL_LENGTH - 1)]->timestamp <= self->monsterinfo.trail_time)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return (trail_head[num] + lo) & (TRAIL_LENGTH - 1);
 }
 
 
 edict_t *PlayerTrail_PickFirst(edict_t *self)
 {
     int     marker;
-    int     n;
+    int     num;
 
     if (!trail_active)
         return NULL;
 
-    for (marker = trail_head, n = TRAIL_LENGTH; n; n--) {
-        if (trail[marker]->timestamp <= self->monsterinfo.trail_time)
-            marker = NEXT(marker);
-        else
-            break;
-    }
+    num = PlayerTrail_EnemyNum(self);
+    if (!trail[num][0])
+        return NULL;
+
+    marker = PlayerTrail_Marker(self, num);
 
-    if (visible(self, trail[marker])) {
-        return trail[marker];
+    if (visible(self, trail[num][marker])) {
+        return trail[num][marker];
     }
 
-    if (visible(self, trail[PREV(marker)])) {
-        return trail[PREV(marker)];
+    if (visible(self, trail[num][PREV(marker)])) {
+        return trail[num][PREV(marker)];
     }
 
-    return trail[marker];
+    return trail[num][marker];
 }
 
 edict_t *PlayerTrail_PickNext(edict_t *self)
 {
-    int     marker;
-    int     n;
+    int     num;
 
     if (!trail_active)
         return NULL;
 
-    for (marker = trail_head, n = TRAIL_LENGTH; n; n--) {
-        if (trail[marker]->timestamp <= self->monsterinfo.trail_time)
-            marker = NEXT(marker);
-        else
-            break;
-    }
+    num = PlayerTrail_EnemyNum(self);
+    if (!trail[num][0])
+        return NULL;
 
-    return trail[marker];
+    return trail[num][PlayerTrail_Marker(self, num)];
 }
 
-edict_t *PlayerTrail_LastSpot(void)
+edict_t *PlayerTrail_LastSpot(edict_t *ent)
 {
-    return trail[PREV(trail_head)];
+    int     num = PlayerTrail_ClientNum(ent);
+
+    return PlayerTrail_Spawn(num)[PREV(trail_head[num])];
 }
@@ -28,6 +28,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "common/cvar.h"
 #include "common/field.h"
 #include "common/files.h"
+#include "common/loadprof.h"
 #include "common/pmove.h"
 #include "common/math.h"
 #include "common/msg.h"
@@ -435,10 +436,18 @@ typedef struct client_static_s {
         int64_t     file_offset;
         int         file_percent;
         sizebuf_t   buffer;
-        list_t      snapshots;
+        struct demosnap_s   **snapshots;    // sorted by frame number
+        int         numsnapshots;
+        char        index[MAX_OSPATH];  // path of .idx file with snapshots
+        bool        indexed;            // index loaded or no longer writable
         bool        paused;
         bool        seeking;
         bool        eof;
+        bool        decoding;           // decode only, don't render
+        uint64_t    decode_start;
+        int         decode_frames;      // frames_read when decoding started
+        unsigned    decode_messages;
+        uint64_t    decode_bytes;
     } demo;
 
 #if USE_CLIENT_GTV
@@ -528,6 +537,7 @@ extern cvar_t    *cl_async;
 // Additions for q2pro-speed
 extern cvar_t    *cl_drawSpeedrunTotalTimer;
 extern cvar_t    *cl_drawSpeedrunLevelTimer;
+extern cvar_t    *cl_drawSpeedrunSplitDelta;
 extern cvar_t    *cl_drawStrafeHelper;
 extern cvar_t    *cl_strafeHelperCenter;
 extern cvar_t    *cl_strafeHelperCenterMarker;
@@ -27,6 +27,9 @@ static byte     demo_buffer[MAX_PACKETLEN];
 static cvar_t   *cl_demosnaps;
 static cvar_t   *cl_demomsglen;
 static cvar_t   *cl_demowait;
+static cvar_t   *cl_demoindex;
+
+static void write_demo_index(void);
 
 // =========================================================================
 
@@ -643,6 +646,9 @@ static int parse_next_message(int wait)
     int ret;
 
     ret = read_next_message(cls.demo.playback);
+    if (ret == 0) {
+        write_demo_index();
+    }
     if (ret < 0 || (ret == 0 && wait == 0)) {
         finish_demo(ret);
         return -1;
@@ -716,6 +722,7 @@ static void CL_PlayDemo_f(void)
     CL_Disconnect(ERR_RECONNECT);
 
     cls.demo.playback = f;
+    Q_concat(cls.demo.index, sizeof(cls.demo.index), name, ".idx", NULL);
     cls.state = ca_connected;
     Q_strlcpy(cls.servername, COM_SkipPath(name), sizeof(cls.servername));
     cls.serverAddress.type = NA_LOOPBACK;
@@ -733,6 +740,26 @@ static void CL_PlayDemo_f(void)
     }
 }
 
+/*
+====================
+CL_DecodeDemo_f
+
+Plays demo back at maximum speed, decoding frames without rendering or
+sound, and prints statistics once finished.
+====================
+*/
+static void CL_DecodeDemo_f(void)
+{
+    CL_PlayDemo_f();
+    if (!cls.demo.playback) {
+        return;
+    }
+
+    S_StopAllSounds();
+    cls.demo.decoding = true;
+    CL_UpdateFrameTimes();
+}
+
 static void CL_Demo_c(genctx_t *ctx, int argnum)
 {
     if (argnum == 1) {
@@ -740,14 +767,21 @@ static void CL_Demo_c(genctx_t *ctx, int argnum)
     }
 }
 
-typedef struct {
-    list_t entry;
+typedef struct demosnap_s {
     int framenum;
     int64_t filepos;
     size_t msglen;
     byte data[1];
 } demosnap_t;
 
+#define MIN_SNAPSHOTS   64
+
+static void add_snapshot(demosnap_t *snap)
+{
+    cls.demo.snapshots = Z_Realloc(cls.demo.snapshots, ALIGN(cls.demo.numsnapshots + 1, MIN_SNAPSHOTS) * sizeof(demosnap_t *));
+    cls.demo.snapshots[cls.demo.numsnapshots++] = snap;
+}
+
 /*
 ====================
 CL_EmitDemoSnapshot
@@ -771,6 +805,11 @@ void CL_EmitDemoSnapshot(void)
     if (cls.demo.frames_read < cls.demo.last_snapshot + cl_demosnaps->integer * 10)
         return;
 
+    // keep snapshots sorted, indexed ones may be ahead of the last level
+    if (cls.demo.numsnapshots &&
+        cls.demo.snapshots[cls.demo.numsnapshots - 1]->framenum >= cls.demo.frames_read)
+        return;
+
     if (!cl.frame.valid)
         return;
 
@@ -825,7 +864,7 @@ void CL_EmitDemoSnapshot(void)
     snap->filepos = pos;
     snap->msglen = msg_write.cursize;
     memcpy(snap->data, msg_write.data, msg_write.cursize);
-    List_Append(&cls.demo.snapshots, &snap->entry);
+    add_snapshot(snap);
 
     Com_DPrintf("[%d] snaplen %"PRIz"\n", cls.demo.frames_read, msg_write.cursize);
 
@@ -834,22 +873,208 @@ void CL_EmitDemoSnapshot(void)
     cls.demo.last_snapshot = cls.demo.frames_read;
 }
 
+static void free_snapshots(void)
+{
+    size_t total = 0;
+    int i;
+
+    for (i = 0; i < cls.demo.numsnapshots; i++) {
+        total += cls.demo.snapshots[i]->msglen;
+        Z_Free(cls.demo.snapshots[i]);
+    }
+
+    Z_Free(cls.demo.snapshots);
+    cls.demo.snapshots = NULL;
+    cls.demo.numsnapshots = 0;
+
+    if (total)
+        Com_DPrintf("Freed %"PRIz" bytes of snaps\n", total);
+}
+
+// returns the last snapshot at or before the given frame, or the first one
 static demosnap_t *find_snapshot(int framenum)
 {
-    demosnap_t *snap, *prev;
+    int lo, hi, mid;
 
-    if (LIST_EMPTY(&cls.demo.snapshots))
+    if (!cls.demo.numsnapshots)
         return NULL;
 
-    prev = LIST_FIRST(demosnap_t, &cls.demo.snapshots, entry);
+    lo = 0;
+    hi = cls.demo.numsnapshots - 1;
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if (cls.demo.snapshots[mid]->framenum > framenum)
+            hi = mid - 1;
+        else
+            lo = mid;
+    }
 
-    LIST_FOR_EACH(demosnap_t, snap, &cls.demo.snapshots, entry) {
-        if (snap->framenum > framenum)
-            break;
-        prev = snap;
+    return cls.demo.snapshots[lo];
+}
+
+/*
+====================
+Demo snapshot index
+
+Snapshots of a fully played demo are saved next to it as <demo>.idx, so that
+later playbacks can seek anywhere in the demo without parsing every message
+up to the destination. The index is tied to the demo by file length, offset
+of the first frame and protocol. It also records the number of frames,
+which the demo browser shows as demo length.
+====================
+*/
+
+#define DEMO_INDEX_MAGIC    MakeRawLong('D', 'I', 'D', 'X')
+#define DEMO_INDEX_VERSION  2
+
+typedef struct {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    protocol;
+    uint32_t    file_offset[2];
+    uint32_t    file_size[2];
+    uint32_t    numsnapshots;
+    uint32_t    numframes;
+} demoindex_t;
+
+typedef struct {
+    uint32_t    framenum;
+    uint32_t    filepos[2];
+    uint32_t    msglen;
+} demoindexsnap_t;
+
+static void put_int64(uint32_t *p, int64_t v)
+{
+    p[0] = LittleLong(v);
+    p[1] = LittleLong(v >> 32);
+}
+
+static int64_t get_int64(const uint32_t *p)
+{
+    return LittleLong(p[0]) | ((int64_t)LittleLong(p[1]) << 32);
+}
+
+static void build_index_header(demoindex_t *hdr)
+{
+    hdr->magic = DEMO_INDEX_MAGIC;
+    hdr->version = LittleLong(DEMO_INDEX_VERSION);
+    hdr->protocol = LittleLong(cls.serverProtocol);
+    put_int64(hdr->file_offset, cls.demo.file_offset);
+    put_int64(hdr->file_size, cls.demo.file_size);
+    hdr->numsnapshots = LittleLong(cls.demo.numsnapshots);
+    hdr->numframes = LittleLong(cls.demo.frames_read);
+}
+
+// called once the demo is played or seeked through to the end
+static void write_demo_index(void)
+{
+    demoindex_t hdr;
+    demoindexsnap_t ent;
+    demosnap_t *snap;
+    qhandle_t f;
+    int i, ret;
+
+    if (!cl_demoindex->integer || cls.demo.indexed || !cls.demo.numsnapshots)
+        return;
+
+    // only try once per playback
+    cls.demo.indexed = true;
+
+    ret = FS_FOpenFile(cls.demo.index, &f, FS_MODE_WRITE);
+    if (!f) {
+        Com_EPrintf("Couldn't open %s for writing: %s\n", cls.demo.index, Q_ErrorString(ret));
+        return;
+    }
+
+    build_index_header(&hdr);
+    ret = FS_Write(&hdr, sizeof(hdr), f);
+
+    for (i = 0; i < cls.demo.numsnapshots && ret >= 0; i++) {
+        snap = cls.demo.snapshots[i];
+        ent.framenum = LittleLong(snap->framenum);
+        put_int64(ent.filepos, snap->filepos);
+        ent.msglen = LittleLong(snap->msglen);
+        ret = FS_Write(&ent, sizeof(ent), f);
+        if (ret >= 0)
+            ret = FS_Write(snap->data, snap->msglen, f);
     }
 
-    return prev;
+    if (FS_FCloseFile(f) || ret < 0) {
+        Com_EPrintf("Couldn't write %s\n", cls.demo.index);
+        return;
+    }
+
+    Com_DPrintf("Wrote %d snapshots to %s\n", cls.demo.numsnapshots, cls.demo.index);
+}
+
+static void read_demo_index(void)
+{
+    demoindex_t hdr, cur;
+    demoindexsnap_t ent;
+    demosnap_t *snap;
+    qhandle_t f;
+    int64_t filepos;
+    int i, count, framenum, ret;
+    size_t msglen;
+
+    if (!cl_demoindex->integer || !cls.demo.index[0])
+        return;
+
+    FS_FOpenFile(cls.demo.index, &f, FS_MODE_READ);
+    if (!f)
+        return;
+
+    ret = FS_Read(&hdr, sizeof(hdr), f);
+    if (ret != sizeof(hdr))
+        goto fail;
+
+    build_index_header(&cur);
+    cur.numsnapshots = hdr.numsnapshots;
+    cur.numframes = hdr.numframes;
+    if (memcmp(&hdr, &cur, sizeof(hdr))) {
+        Com_DPrintf("%s doesn't match the demo, will be rebuilt\n", cls.demo.index);
+        goto done;
+    }
+
+    count = LittleLong(hdr.numsnapshots);
+    framenum = INT_MIN;
+    for (i = 0; i < count; i++) {
+        ret = FS_Read(&ent, sizeof(ent), f);
+        if (ret != sizeof(ent))
+            goto fail;
+
+        filepos = get_int64(ent.filepos);
+        msglen = LittleLong(ent.msglen);
+        if ((int)LittleLong(ent.framenum) <= framenum || msglen > MAX_MSGLEN ||
+            filepos < cls.demo.file_offset ||
+            filepos > cls.demo.file_offset + cls.demo.file_size)
+            goto fail;
+        framenum = LittleLong(ent.framenum);
+
+        snap = Z_Malloc(sizeof(*snap) + msglen - 1);
+        snap->framenum = framenum;
+        snap->filepos = filepos;
+        snap->msglen = msglen;
+        add_snapshot(snap);
+
+        ret = FS_Read(snap->data, msglen, f);
+        if (ret != msglen)
+            goto fail;
+    }
+
+    if (cls.demo.numsnapshots) {
+        cls.demo.last_snapshot = framenum;
+        cls.demo.indexed = true;
+    }
+
+    Com_DPrintf("Read %d snapshots from %s\n", cls.demo.numsnapshots, cls.demo.index);
+    goto done;
+
+fail:
+    Com_WPrintf("%s is corrupted, will be rebuilt\n", cls.demo.index);
+    free_snapshots();
+done:
+    FS_FCloseFile(f);
 }
 
 /*
@@ -884,6 +1109,13 @@ void CL_FirstDemoFrame(void)
 
     // force initial snapshot
     cls.demo.last_snapshot = INT_MIN;
+
+    // snapshots of the previous level don't have matching base
+    // configstrings, never save them
+    if (cls.demo.numsnapshots)
+        cls.demo.indexed = true;
+    else if (cls.demo.file_size)
+        read_demo_index();
 }
 
 static void CL_Seek_f(void)
@@ -955,6 +1187,10 @@ static void CL_Seek_f(void)
     if (frames < 0 || cls.demo.last_snapshot > cls.demo.frames_read) {
         snap = find_snapshot(dest);
 
+        // parsing forward from the current frame may be quicker
+        if (snap && frames > 0 && snap->framenum <= cls.demo.frames_read)
+            snap = NULL;
+
         if (snap) {
             Com_DPrintf("found snap at %d\n", snap->framenum);
             ret = FS_Seek(cls.demo.playback, snap->filepos);
@@ -993,6 +1229,9 @@ static void CL_Seek_f(void)
     // skip forward to destination frame
     while (cls.demo.frames_read < dest) {
         ret = read_next_message(cls.demo.playback);
+        if (ret == 0) {
+            write_demo_index();
+        }
         if (ret == 0 && cl_demowait->integer) {
             cls.demo.eof = true;
             break;
@@ -1069,6 +1308,50 @@ static void parse_info_string(demoInfo_t *info, int clientNum, int index, const
     }
 }
 
+/*
+====================
+read_index_frames
+
+Returns number of frames recorded in the snapshot index of the demo, or 0
+if there is no index matching the demo. Counting frames by reading the
+whole demo is too slow for the demo browser.
+====================
+*/
+static int read_index_frames(const char *path, qhandle_t f)
+{
+    char buffer[MAX_OSPATH];
+    demoindex_t hdr;
+    qhandle_t idx;
+    int64_t len;
+    int ret;
+
+    len = FS_Length(f);
+    if (len <= 0) {
+        return 0;
+    }
+
+    if (Q_concat(buffer, sizeof(buffer), path, ".idx", NULL) >= sizeof(buffer)) {
+        return 0;
+    }
+
+    FS_FOpenFile(buffer, &idx, FS_MODE_READ);
+    if (!idx) {
+        return 0;
+    }
+
+    ret = FS_Read(&hdr, sizeof(hdr), idx);
+    FS_FCloseFile(idx);
+
+    if (ret != sizeof(hdr) || hdr.magic != DEMO_INDEX_MAGIC ||
+        LittleLong(hdr.version) != DEMO_INDEX_VERSION ||
+        LittleLong(hdr.protocol) != PROTOCOL_VERSION_DEFAULT ||
+        get_int64(hdr.file_offset) + get_int64(hdr.file_size) != len) {
+        return 0;
+    }
+
+    return LittleLong(hdr.numframes);
+}
+
 /*
 ====================
 CL_GetDemoInfo
@@ -1123,6 +1406,7 @@ demoInfo_t *CL_GetDemoInfo(const char *path, demoInfo_t *info)
             parse_info_string(info, clientNum, index, string);
         }
 
+        info->frames = read_index_frames(path, f);
         info->mvd = false;
     } else {
         if ((MSG_ReadByte() & SVCMD_MASK) != mvd_serverdata) {
@@ -1164,9 +1448,6 @@ fail:
 
 void CL_CleanupDemos(void)
 {
-    demosnap_t *snap, *next;
-    size_t total;
-
     if (cls.demo.recording) {
         CL_Stop_f();
     }
@@ -1187,18 +1468,60 @@ void CL_CleanupDemos(void)
         }
     }
 
-    total = 0;
-    LIST_FOR_EACH_SAFE(demosnap_t, snap, next, &cls.demo.snapshots, entry) {
-        total += snap->msglen;
-        Z_Free(snap);
+    free_snapshots();
+
+    memset(&cls.demo, 0, sizeof(cls.demo));
+}
+
+// limits time spent decoding per client frame to keep console responsive
+#define DECODE_USEC     100000
+
+static void print_decode_stats(void)
+{
+    uint64_t usec = Sys_Microseconds() - cls.demo.decode_start;
+    int frames = cls.demo.frames_read - cls.demo.decode_frames;
+    int sec = frames / 10;
+
+    Com_Printf("Decoded %d frames (%d:%02d:%02d) in %.3f sec, %.1fx realtime, "
+               "%.1f usec/frame\n", frames, sec / 3600, sec / 60 % 60, sec % 60,
+               usec * 1e-6, usec ? frames * 1e5 / usec : 0.0,
+               frames ? (double)usec / frames : 0.0);
+    Com_Printf("%u messages, %"PRIu64" bytes\n",
+               cls.demo.decode_messages, cls.demo.decode_bytes);
+}
+
+// runs messages through the seeking parser, which skips effects and
+// configstring updates, until end of file or time limit is hit
+static void decode_demo_frames(void)
+{
+    uint64_t start = Sys_Microseconds();
+    int ret;
+
+    if (!cls.demo.decode_start) {
+        cls.demo.decode_start = start;
+        cls.demo.decode_frames = cls.demo.frames_read;
     }
 
-    if (total)
-        Com_DPrintf("Freed %"PRIz" bytes of snaps\n", total);
+    cls.demo.seeking = true;
+    do {
+        ret = read_next_message(cls.demo.playback);
+        if (ret <= 0) {
+            cls.demo.seeking = false;
+            if (ret == 0) {
+                write_demo_index();
+            }
+            print_decode_stats();
+            finish_demo(ret);
+            return;
+        }
 
-    memset(&cls.demo, 0, sizeof(cls.demo));
+        cls.demo.decode_messages++;
+        cls.demo.decode_bytes += msg_read.cursize;
 
-    List_Init(&cls.demo.snapshots);
+        CL_SeekDemoMessage();
+        CL_EmitDemoSnapshot();
+    } while (Sys_Microseconds() - start < DECODE_USEC);
+    cls.demo.seeking = false;
 }
 
 /*
@@ -1217,6 +1540,11 @@ void CL_DemoFrame(int msec)
         return;
     }
 
+    if (cls.demo.decoding) {
+        decode_demo_frames();
+        return;
+    }
+
     if (com_timedemo->integer) {
         parse_next_message(0);
         cl.time = cl.servertime;
@@ -1243,6 +1571,7 @@ void CL_DemoFrame(int msec)
 
 static const cmdreg_t c_demo[] = {
     { "demo", CL_PlayDemo_f, CL_Demo_c },
+    { "decodedemo", CL_DecodeDemo_f, CL_Demo_c },
     { "record", CL_Record_f, CL_Demo_c },
     { "stop", CL_Stop_f },
     { "suspend", CL_Suspend_f },
@@ -1262,6 +1591,7 @@ void CL_InitDemos(void)
     cl_demomsglen = Cvar_Get("cl_demomsglen", va("%d", MAX_PACKETLEN_WRITABLE_DEFAULT), 0);
     cl_demowait = Cvar_Get("cl_demowait", "0", 0);
 
+    cl_demoindex = Cvar_Get("cl_demoindex", "1", 0);
+
     Cmd_Register(c_demo);
-    List_Init(&cls.demo.snapshots);
 }
@@ -72,6 +72,7 @@ cvar_t  *cl_vwep;
 // Additions for q2pro-speed
 cvar_t  *cl_drawSpeedrunTotalTimer;
 cvar_t  *cl_drawSpeedrunLevelTimer;
+cvar_t  *cl_drawSpeedrunSplitDelta;
 cvar_t  *cl_drawStrafeHelper;
 cvar_t  *cl_strafeHelperCenter;
 cvar_t  *cl_strafeHelperCenterMarker;
@@ -1769,6 +1770,7 @@ void CL_Begin(void)
     LOC_LoadLocations();
     CL_LoadState(LOAD_NONE);
     cls.state = ca_precached;
+    LoadProf_EndLevel();
 
 #if USE_FPS
     CL_UpdateRateSetting();
@@ -1801,6 +1803,10 @@ static void CL_Precache_f(void)
     cls.state = ca_loading;
     CL_LoadState(LOAD_MAP);
 
+    // local server has already started the profile
+    if (!LoadProf_Active())
+        LoadProf_BeginLevel(cl.mapname);
+
     S_StopAllSounds();
 
     CL_RegisterVWepModels();
@@ -1813,6 +1819,7 @@ static void CL_Precache_f(void)
         CL_RegisterSounds();
         CL_LoadState(LOAD_NONE);
         cls.state = ca_precached;
+        LoadProf_EndLevel();
         return;
     }
 
@@ -2733,6 +2740,7 @@ static void CL_InitLocal(void)
     // Additions for q2pro-speed
     cl_drawSpeedrunTotalTimer = Cvar_Get("cl_drawtotaltimer", "0", CVAR_ARCHIVE);
     cl_drawSpeedrunLevelTimer = Cvar_Get("cl_drawleveltimer", "0", CVAR_ARCHIVE);
+    cl_drawSpeedrunSplitDelta = Cvar_Get("cl_drawsplitdelta", "0", CVAR_ARCHIVE);
     cl_drawStrafeHelper = Cvar_Get("cl_drawstrafehelper", "0", CVAR_ARCHIVE);
     cl_strafeHelperCenter = Cvar_Get("cl_strafehelpercenter", "1", CVAR_ARCHIVE);
     cl_strafeHelperCenterMarker = Cvar_Get("cl_strafehelpercentermarker", "1", CVAR_ARCHIVE);
@@ -3102,7 +3110,7 @@ void CL_UpdateFrameTimes(void)
     phys_msec = ref_msec = main_msec = 0;
     ref_extra = phys_extra = main_extra = 0;
 
-    if (com_timedemo->integer) {
+    if (com_timedemo->integer || cls.demo.decoding) {
         // timedemo just runs at full speed
         sync_mode = SYNC_TIMEDEMO;
     } else if (cls.active == ACT_MINIMIZED) {
@@ -3152,6 +3160,9 @@ unsigned CL_Frame(unsigned msec)
     switch (sync_mode) {
     case SYNC_TIMEDEMO:
         // timedemo just runs at full speed
+        // decoding demo doesn't render or play sounds at all
+        if (cls.demo.decoding)
+            ref_frame = false;
         break;
     case SYNC_SLEEP_10:
         // don't run refresh at all
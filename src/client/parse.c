@@ -1072,7 +1072,7 @@ static void CL_ParseZPacket(void)
     byte        buffer[MAX_MSGLEN];
     int         inlen, outlen;
 
-    if (msg_read.data != msg_read_buffer) {
+    if (msg_read.tag == SZ_CL_ZPACKET) {
         Com_Error(ERR_DROP, "%s: recursively entered", __func__);
     }
 
@@ -1102,6 +1102,7 @@ static void CL_ParseZPacket(void)
     temp = msg_read;
     SZ_Init(&msg_read, buffer, outlen);
     msg_read.cursize = outlen;
+    msg_read.tag = SZ_CL_ZPACKET;
 
     CL_ParseServerMessage();
 
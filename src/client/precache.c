@@ -21,6 +21,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 //
 
 #include "client.h"
+#include "speedrun/timer.h"
 
 /*
 ================
@@ -203,6 +204,8 @@ void CL_RegisterSounds(void)
     int i;
     char    *s;
 
+    SpeedrunBeginLoad(SPEEDRUN_LOAD_REGISTRATION);
+    LoadProf_Begin("CL_RegisterSounds", NULL);
     S_BeginRegistration();
     CL_RegisterTEntSounds();
     for (i = 1; i < MAX_SOUNDS; i++) {
@@ -211,7 +214,11 @@ void CL_RegisterSounds(void)
             break;
         cl.sound_precache[i] = S_RegisterSound(s);
     }
+    LoadProf_Begin("S_EndRegistration", NULL);
     S_EndRegistration();
+    LoadProf_End();
+    LoadProf_End();
+    SpeedrunEndLoad(SPEEDRUN_LOAD_REGISTRATION);
 }
 
 /*
@@ -334,9 +341,14 @@ void CL_PrepRefresh(void)
         return;     // no map loaded
 
     // register models, pics, and skins
+    SpeedrunBeginLoad(SPEEDRUN_LOAD_REGISTRATION);
+    LoadProf_Begin("CL_PrepRefresh", cl.mapname);
+    LoadProf_Begin("R_BeginRegistration", NULL);
     R_BeginRegistration(cl.mapname);
+    LoadProf_End();
 
     CL_LoadState(LOAD_MODELS);
+    LoadProf_Begin("models", NULL);
 
     CL_RegisterTEntModels();
 
@@ -351,7 +363,10 @@ void CL_PrepRefresh(void)
         cl.model_draw[i] = R_RegisterModel(name);
     }
 
+    LoadProf_End();
+
     CL_LoadState(LOAD_IMAGES);
+    LoadProf_Begin("images", NULL);
     for (i = 1; i < MAX_IMAGES; i++) {
         name = cl.configstrings[CS_IMAGES + i];
         if (!name[0]) {
@@ -360,7 +375,10 @@ void CL_PrepRefresh(void)
         cl.image_precache[i] = R_RegisterPic2(name);
     }
 
+    LoadProf_End();
+
     CL_LoadState(LOAD_CLIENTS);
+    LoadProf_Begin("clientinfo", NULL);
     for (i = 0; i < MAX_CLIENTS; i++) {
         name = cl.configstrings[CS_PLAYERSKINS + i];
         if (!name[0]) {
@@ -370,12 +388,17 @@ void CL_PrepRefresh(void)
     }
 
     CL_LoadClientinfo(&cl.baseclientinfo, "unnamed\\male/grunt");
+    LoadProf_End();
 
     // set sky textures and speed
     CL_SetSky();
 
     // the renderer can now free unneeded stuff
+    LoadProf_Begin("R_EndRegistration", NULL);
     R_EndRegistration();
+    LoadProf_End();
+    LoadProf_End();
+    SpeedrunEndLoad(SPEEDRUN_LOAD_REGISTRATION);
 
     // clear any lines of console text
     Con_ClearNotify_f();
@@ -18,6 +18,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 // cl_scrn.c -- master for refresh, status bar, console, chat, notify, etc
 
 #include "client.h"
+#include "speedrun/splits.h"
 #include "speedrun/timer.h"
 #include "../speedrun/strafe_helper/strafe_helper.h"
 
@@ -39,6 +40,7 @@ static struct {
     bool        draw_loading;
 
     qhandle_t   sb_pics[2][STAT_PICS];
+    int         sb_width, sb_height;
     qhandle_t   inven_pic;
     qhandle_t   field_pic;
 
@@ -1174,6 +1176,7 @@ void SCR_RegisterMedia(void)
     for (i = 0; i < 2; i++)
         for (j = 0; j < STAT_PICS; j++)
             scr.sb_pics[i][j] = R_RegisterPic(sb_nums[i][j]);
+    R_GetPicSize(&scr.sb_width, &scr.sb_height, scr.sb_pics[0][0]);
 
     scr.inven_pic = R_RegisterPic("inventory");
     scr.field_pic = R_RegisterPic("field_3");
@@ -1907,32 +1910,68 @@ draw:
     SCR_ExecuteLayoutString(cl.layout);
 }
 
-static void SCR_DrawTimeString(
-        int x, int y, const char time_string[static SPEEDRUN_TIME_LENGTH])
+// Speedrun timers are drawn with the big HUD digits. The glyph layout is
+// only rebuilt when the displayed digits change, which at high frame rates
+// is a small fraction of the frames drawn.
+typedef struct {
+    int         x;
+    int         digit;
+} timer_glyph_t;
+
+typedef struct {
+    int             accuracy;
+    uint64_t        units;      // displayed value in units of the last digit
+    int             numglyphs;
+    timer_glyph_t   glyphs[SPEEDRUN_TIME_LENGTH];
+} timer_cache_t;
+
+static timer_cache_t    scr_total_timer;
+static timer_cache_t    scr_level_timer;
+
+static void SCR_UpdateTimerCache(timer_cache_t *cache, uint64_t time,
+                                 int accuracy)
 {
+    static const uint64_t units_per_accuracy[] = { 1000000, 100000, 10000, 1000 };
     const int SEPARATOR_WIDTH = 8;
-    const int DEFAULT_COLOR = 0;
+    char time_string[SPEEDRUN_TIME_LENGTH];
+    uint64_t units;
+    int x, i;
 
-    int last_char = SPEEDRUN_TIME_LENGTH - 1;
-    while (time_string[last_char] == '\0')
-    {
-        last_char -= 1;
-    }
+    clamp(accuracy, 0, 3);
+    units = time / units_per_accuracy[accuracy];
+    if (cache->numglyphs && cache->accuracy == accuracy && cache->units == units)
+        return;
 
-    for (int i = last_char; i >= 0; i -= 1)
-    {
-        if (isdigit(time_string[i]))
-        {
+    cache->accuracy = accuracy;
+    cache->units = units;
+    cache->numglyphs = 0;
+
+    SpeedrunGetTimeString(time / 1000, accuracy, time_string);
+
+    // lay out right to left, relative to the right edge
+    x = 0;
+    for (i = strlen(time_string) - 1; i >= 0; i--) {
+        if (Q_isdigit(time_string[i])) {
             x -= DIGIT_WIDTH;
-            HUD_DrawNumber(x, y, DEFAULT_COLOR, 1, time_string[i] - '0');
-        }
-        else
-        {
+            cache->glyphs[cache->numglyphs].x = x + 2;
+            cache->glyphs[cache->numglyphs].digit = time_string[i] - '0';
+            cache->numglyphs++;
+        } else {
             x -= SEPARATOR_WIDTH;
         }
     }
 }
 
+static void SCR_DrawTimerCache(int x, int y, const timer_cache_t *cache)
+{
+    const timer_glyph_t *glyph;
+    int i;
+
+    for (i = 0, glyph = cache->glyphs; i < cache->numglyphs; i++, glyph++)
+        R_DrawStretchPic(x + glyph->x, y, scr.sb_width, scr.sb_height,
+                         scr.sb_pics[0][glyph->digit]);
+}
+
 static void SCR_DrawStrafeHelper(void)
 {
     const struct StrafeHelperParams params = {
@@ -1950,20 +1989,31 @@ static int SCR_DrawSpeedrunTimer(int x, int y)
     const int TIMER_HEIGHT = 25;
     if ( cl_drawSpeedrunTotalTimer->integer > 0 )
     {
-        char total_time_string[SPEEDRUN_TIME_LENGTH];
         const int total_time_accuracy = cl_drawSpeedrunTotalTimer->integer - 1;
-        SpeedrunGetTotalTimeString(total_time_accuracy, total_time_string);
-        SCR_DrawTimeString(x, y, total_time_string);
+        SCR_UpdateTimerCache(&scr_total_timer, SpeedrunGetTotalTime(),
+                             total_time_accuracy);
+        SCR_DrawTimerCache(x, y, &scr_total_timer);
         y += TIMER_HEIGHT;
     }
     if ( cl_drawSpeedrunLevelTimer->integer > 0 )
     {
-        char level_time_string[SPEEDRUN_TIME_LENGTH];
         const int level_time_accuracy = cl_drawSpeedrunLevelTimer->integer - 1;
-        SpeedrunGetLevelTimeString(level_time_accuracy, level_time_string);
-        SCR_DrawTimeString(x, y, level_time_string);
+        SCR_UpdateTimerCache(&scr_level_timer, SpeedrunGetLevelTime(),
+                             level_time_accuracy);
+        SCR_DrawTimerCache(x, y, &scr_level_timer);
         y += TIMER_HEIGHT;
     }
+    if ( cl_drawSpeedrunSplitDelta->integer > 0 )
+    {
+        bool behind;
+        const char *delta_string = SpeedrunGetSplitDelta(&behind);
+        if (delta_string)
+        {
+            const int flags = UI_RIGHT | (behind ? 0 : UI_ALTCOLOR);
+            SCR_DrawString(x, y, flags, delta_string);
+            y += CHAR_HEIGHT;
+        }
+    }
     return y;
 }
 
@@ -310,7 +310,9 @@ sfxcache_t *S_LoadSound(sfx_t *s)
     else
         name = s->name;
 
+    LoadProf_Begin("S file", name);
     len = FS_LoadFile(name, (void **)&data);
+    LoadProf_End();
     if (!data) {
         s->error = len;
         return NULL;
@@ -326,6 +328,8 @@ sfxcache_t *S_LoadSound(sfx_t *s)
         goto fail;
     }
 
+    LoadProf_Begin("S upload", name);
+
 #if USE_OPENAL
     if (s_started == SS_OAL)
         sc = AL_UploadSfx(s);
@@ -336,6 +340,8 @@ sfxcache_t *S_LoadSound(sfx_t *s)
         sc = ResampleSfx(s);
 #endif
 
+    LoadProf_End();
+
 fail:
     FS_FreeFile(data);
     return sc;
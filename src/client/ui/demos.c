@@ -19,6 +19,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "ui.h"
 #include "common/files.h"
 #include "common/mdfour.h"
+#include "system/system.h"
 
 /*
 =======================================================================
@@ -35,6 +36,12 @@ DEMOS MENU
 #define DEMO_MVD_POV    "\x90\xcd\xd6\xc4\x91" // [MVD]
 #define DEMO_DIR_SIZE   "\x90\xc4\xc9\xd2\x91" // [DIR]
 
+// bumped whenever cache format changes, mixed into the directory hash
+#define DEMO_CACHE_VERSION  "2"
+
+// msec spent scanning demos per menu frame
+#define DEMO_SCAN_MSEC  10
+
 #define ENTRY_UP    1
 #define ENTRY_DN    2
 #define ENTRY_DEMO  3
@@ -44,10 +51,13 @@ DEMOS MENU
 #define COL_SIZE    2
 #define COL_MAP     3
 #define COL_POV     4
-#define COL_MAX     5
+#define COL_TIME    5
+#define COL_MAX     6
 
 typedef struct {
     unsigned    type;
+    int         index;      // position in directory listing
+    int         frames;
     int64_t     size;
     time_t      mtime;
     char        name[1];
@@ -64,6 +74,9 @@ typedef struct m_demos_s {
     int             widest_map, widest_pov;
     uint64_t        total_bytes;
     char            status[32];
+    void            **demolist;     // demos not scanned yet
+    int             numDemos;
+    int             numScanned;
 } m_demos_t;
 
 static m_demos_t    m_demos;
@@ -75,6 +88,7 @@ static void BuildName(const file_info_t *info, char **cache)
 {
     char buffer[MAX_OSPATH];
     char date[MAX_QPATH];
+    char length[16];
     demoInfo_t demo;
     demoEntry_t *e;
     struct tm *tm;
@@ -96,6 +110,12 @@ static void BuildName(const file_info_t *info, char **cache)
                 *p = 0;
                 Q_strlcpy(demo.pov, s, sizeof(demo.pov));
                 s = p + 1;
+                p = strchr(s, '\\');
+                if (p) {
+                    *p = 0;
+                    demo.frames = atoi(s);
+                    s = p + 1;
+                }
             }
         }
         *cache = s;
@@ -134,11 +154,26 @@ static void BuildName(const file_info_t *info, char **cache)
         strcpy(date, "???");
     }
 
+    // format length, demos run at 10 frames per second
+    if (demo.frames > 0) {
+        int sec = demo.frames / 10;
+        if (sec >= 3600) {
+            Q_snprintf(length, sizeof(length), "%d:%02d:%02d",
+                       sec / 3600, sec / 60 % 60, sec % 60);
+        } else {
+            Q_snprintf(length, sizeof(length), "%d:%02d", sec / 60, sec % 60);
+        }
+    } else {
+        strcpy(length, "?");
+    }
+
     Com_FormatSize(buffer, sizeof(buffer), info->size);
 
-    e = UI_FormatColumns(DEMO_EXTRASIZE,
-                         info->name, date, buffer, demo.map, demo.pov, NULL);
+    e = UI_FormatColumns(DEMO_EXTRASIZE, info->name, date, buffer,
+                         demo.map, demo.pov, length, NULL);
     e->type = ENTRY_DEMO;
+    e->index = m_demos.list.numItems - m_demos.numDirs;
+    e->frames = demo.frames;
     e->size = info->size;
     e->mtime = info->mtime;
 
@@ -149,9 +184,11 @@ static void BuildName(const file_info_t *info, char **cache)
 
 static void BuildDir(const char *name, int type)
 {
-    demoEntry_t *e = UI_FormatColumns(DEMO_EXTRASIZE, name, "-", DEMO_DIR_SIZE, "-", "-", NULL);
+    demoEntry_t *e = UI_FormatColumns(DEMO_EXTRASIZE, name, "-", DEMO_DIR_SIZE, "-", "-", "-", NULL);
 
     e->type = type;
+    e->index = 0;
+    e->frames = 0;
     e->size = 0;
     e->mtime = 0;
 
@@ -203,12 +240,13 @@ static void WriteCache(void)
 {
     char buffer[MAX_OSPATH];
     qhandle_t f;
-    int i;
+    int i, count;
     char *map, *pov;
-    demoEntry_t *e;
+    demoEntry_t *e, **entries;
     size_t len;
 
-    if (m_demos.list.numItems == m_demos.numDirs) {
+    count = m_demos.list.numItems - m_demos.numDirs;
+    if (!count) {
         return;
     }
 
@@ -226,26 +264,46 @@ static void WriteCache(void)
     }
     FS_FPrintf(f, "\\");
 
+    // list may have been sorted while scanning, restore listing order
+    entries = UI_Malloc(sizeof(entries[0]) * count);
     for (i = m_demos.numDirs; i < m_demos.list.numItems; i++) {
         e = m_demos.list.items[i];
+        entries[e->index] = e;
+    }
+
+    for (i = 0; i < count; i++) {
+        e = entries[i];
         map = UI_GetColumn(e->name, COL_MAP);
         pov = UI_GetColumn(e->name, COL_POV);
-        FS_FPrintf(f, "%s\\%s\\", map, pov);
+        FS_FPrintf(f, "%s\\%s\\%d\\", map, pov, e->frames);
     }
     FS_FCloseFile(f);
+    Z_Free(entries);
 }
 
-static void CalcHash(void **list)
+static void HashList(struct mdfour *md, void **list)
 {
-    struct mdfour md;
     file_info_t *info;
     size_t len;
 
-    mdfour_begin(&md);
     while (*list) {
         info = *list++;
         len = sizeof(*info) + strlen(info->name) - 1;
-        mdfour_update(&md, (uint8_t *)info, len);
+        mdfour_update(md, (uint8_t *)info, len);
+    }
+}
+
+// demo length comes from snapshot index, so cache is rebuilt when
+// indexes are added or changed
+static void CalcHash(void **list, void **idxlist)
+{
+    struct mdfour md;
+
+    mdfour_begin(&md);
+    mdfour_update(&md, (uint8_t *)DEMO_CACHE_VERSION, strlen(DEMO_CACHE_VERSION));
+    HashList(&md, list);
+    if (idxlist) {
+        HashList(&md, idxlist);
     }
     mdfour_result(&md, m_demos.hash);
 }
@@ -272,13 +330,71 @@ static menuSound_t Change(menuCommon_t *self)
     return QMS_SILENT;
 }
 
+static void FinishList(void)
+{
+    size_t len;
+    int i;
+
+    // update status line and sort
+    Change(&m_demos.list.generic);
+    if (m_demos.list.sortdir) {
+        m_demos.list.sort(&m_demos.list);
+    }
+
+    // resize columns
+    m_demos.menu.size(&m_demos.menu);
+
+    // format our extra status line
+    i = m_demos.list.numItems - m_demos.numDirs;
+    len = Q_scnprintf(m_demos.status, sizeof(m_demos.status),
+                      "%d demo%s, ", i, i == 1 ? "" : "s");
+    Com_FormatSizeLong(m_demos.status + len, sizeof(m_demos.status) - len,
+                       m_demos.total_bytes);
+}
+
+/*
+=================
+ScanDemos
+
+Parses uncached demos for a limited time each menu frame, so that large
+directories populate the list incrementally instead of freezing the menu.
+=================
+*/
+static void ScanDemos(void)
+{
+    unsigned start = Sys_Milliseconds();
+
+    while (m_demos.numScanned < m_demos.numDemos) {
+        BuildName(m_demos.demolist[m_demos.numScanned++], NULL);
+        if (Sys_Milliseconds() - start >= DEMO_SCAN_MSEC) {
+            break;
+        }
+    }
+
+    if (m_demos.list.sortdir) {
+        m_demos.list.sort(&m_demos.list);
+    }
+    m_demos.menu.size(&m_demos.menu);
+
+    if (m_demos.numScanned < m_demos.numDemos) {
+        Q_snprintf(m_demos.status, sizeof(m_demos.status), "Scanning %d/%d...",
+                   m_demos.numScanned, m_demos.numDemos);
+        return;
+    }
+
+    WriteCache();
+    FS_FreeList(m_demos.demolist);
+    m_demos.demolist = NULL;
+
+    FinishList();
+}
+
 static void BuildList(void)
 {
-    int numDirs, numDemos;
-    void **dirlist, **demolist;
+    int numDirs, numDemos, numIndexes;
+    void **dirlist, **demolist, **idxlist;
     char *cache, *p;
     unsigned flags;
-    size_t len;
     int i;
 
     // this can be a lengthy process
@@ -294,6 +410,8 @@ static void BuildList(void)
     demolist = FS_ListFiles(m_demos.browse, DEMO_EXTENSIONS, flags |
                             FS_SEARCH_EXTRAINFO, &numDemos);
     numDemos = min(numDemos, MAX_LISTED_FILES - numDirs);
+    idxlist = FS_ListFiles(m_demos.browse, ".idx", flags |
+                           FS_SEARCH_EXTRAINFO, &numIndexes);
 
     // alloc entries
     m_demos.list.items = UI_Malloc(sizeof(demoEntry_t *) * (numDirs + numDemos + 1));
@@ -324,41 +442,31 @@ static void BuildList(void)
 
     // add demos
     if (demolist) {
-        CalcHash(demolist);
-        if ((cache = LoadCache(demolist)) != NULL) {
-            p = cache + 32 + 1;
-            for (i = 0; i < numDemos; i++) {
-                BuildName(demolist[i], &p);
-            }
-            FS_FreeFile(cache);
-        } else {
-            for (i = 0; i < numDemos; i++) {
-                BuildName(demolist[i], NULL);
-                if ((i & 7) == 0) {
-                    m_demos.menu.size(&m_demos.menu);
-                    SCR_UpdateScreen();
-                }
+        CalcHash(demolist, idxlist);
+        if ((cache = LoadCache(demolist)) == NULL) {
+            // parse them in the background while the menu is drawn
+            m_demos.demolist = demolist;
+            m_demos.numDemos = numDemos;
+            m_demos.numScanned = 0;
+            m_demos.menu.status = "Scanning demos...";
+            if (idxlist) {
+                FS_FreeList(idxlist);
             }
+            return;
         }
-        WriteCache();
+        p = cache + 32 + 1;
+        for (i = 0; i < numDemos; i++) {
+            BuildName(demolist[i], &p);
+        }
+        FS_FreeFile(cache);
         FS_FreeList(demolist);
     }
 
-    // update status line and sort
-    Change(&m_demos.list.generic);
-    if (m_demos.list.sortdir) {
-        m_demos.list.sort(&m_demos.list);
+    if (idxlist) {
+        FS_FreeList(idxlist);
     }
 
-    // resize columns
-    m_demos.menu.size(&m_demos.menu);
-
-    // format our extra status line
-    i = m_demos.list.numItems - m_demos.numDirs;
-    len = Q_scnprintf(m_demos.status, sizeof(m_demos.status),
-                      "%d demo%s, ", i, i == 1 ? "" : "s");
-    Com_FormatSizeLong(m_demos.status + len, sizeof(m_demos.status) - len,
-                       m_demos.total_bytes);
+    FinishList();
 
     SCR_UpdateScreen();
 }
@@ -367,6 +475,11 @@ static void FreeList(void)
 {
     int i;
 
+    if (m_demos.demolist) {
+        FS_FreeList(m_demos.demolist);
+        m_demos.demolist = NULL;
+    }
+
     if (m_demos.list.items) {
         for (i = 0; i < m_demos.list.numItems; i++) {
             Z_Free(m_demos.list.items[i]);
@@ -498,6 +611,20 @@ static int timecmp(const void *p1, const void *p2)
     return 0;
 }
 
+static int framecmp(const void *p1, const void *p2)
+{
+    demoEntry_t *e1 = *(demoEntry_t **)p1;
+    demoEntry_t *e2 = *(demoEntry_t **)p2;
+
+    if (e1->frames > e2->frames) {
+        return m_demos.list.sortdir;
+    }
+    if (e1->frames < e2->frames) {
+        return -m_demos.list.sortdir;
+    }
+    return 0;
+}
+
 static int namecmp(const void *p1, const void *p2)
 {
     demoEntry_t *e1 = *(demoEntry_t **)p1;
@@ -522,6 +649,9 @@ static menuSound_t Sort(menuList_t *self)
     case COL_SIZE:
         MenuList_Sort(&m_demos.list, m_demos.numDirs, sizecmp);
         break;
+    case COL_TIME:
+        MenuList_Sort(&m_demos.list, m_demos.numDirs, framecmp);
+        break;
     }
 
     return QMS_SILENT;
@@ -536,8 +666,8 @@ static void Size(menuFrameWork_t *self)
     m_demos.list.generic.width  = 0;
     m_demos.list.generic.height = uis.height - CHAR_HEIGHT * 2 - 1;
 
-    w1 = 17 + m_demos.widest_map + m_demos.widest_pov;
-    w2 = uis.width - w1 * CHAR_WIDTH - MLIST_PADDING * 4 - MLIST_SCROLLBAR_WIDTH;
+    w1 = 24 + m_demos.widest_map + m_demos.widest_pov;
+    w2 = uis.width - w1 * CHAR_WIDTH - MLIST_PADDING * 5 - MLIST_SCROLLBAR_WIDTH;
     if (w2 > 8 * CHAR_WIDTH) {
         // everything fits
         m_demos.list.columns[0].width = w2;
@@ -545,16 +675,18 @@ static void Size(menuFrameWork_t *self)
         m_demos.list.columns[2].width = 5 * CHAR_WIDTH + MLIST_PADDING;
         m_demos.list.columns[3].width = m_demos.widest_map * CHAR_WIDTH + MLIST_PADDING;
         m_demos.list.columns[4].width = m_demos.widest_pov * CHAR_WIDTH + MLIST_PADDING;
+        m_demos.list.columns[5].width = 7 * CHAR_WIDTH + MLIST_PADDING;
         m_demos.list.numcolumns = COL_MAX;
     } else {
-        // map and pov don't fit
+        // map, pov and length don't fit
         w2 = uis.width - 17 * CHAR_WIDTH - MLIST_PADDING * 2 - MLIST_SCROLLBAR_WIDTH;
         m_demos.list.columns[0].width = w2;
         m_demos.list.columns[1].width = 12 * CHAR_WIDTH + MLIST_PADDING;
         m_demos.list.columns[2].width = 5 * CHAR_WIDTH + MLIST_PADDING;
         m_demos.list.columns[3].width = 0;
         m_demos.list.columns[4].width = 0;
-        m_demos.list.numcolumns = COL_MAX - 2;
+        m_demos.list.columns[5].width = 0;
+        m_demos.list.numcolumns = COL_MAX - 3;
     }
 }
 
@@ -570,6 +702,10 @@ static menuSound_t Keydown(menuFrameWork_t *self, int key)
 
 static void Draw(menuFrameWork_t *self)
 {
+    if (m_demos.demolist) {
+        ScanDemos();
+    }
+
     Menu_Draw(self);
     if (uis.width >= 640) {
         UI_DrawString(uis.width, uis.height - CHAR_HEIGHT,
@@ -678,6 +814,8 @@ void M_Menu_Demos(void)
     m_demos.list.columns[3].uiFlags = UI_CENTER;
     m_demos.list.columns[4].name    = "POV";
     m_demos.list.columns[4].uiFlags = UI_CENTER;
+    m_demos.list.columns[5].name    = "Time";
+    m_demos.list.columns[5].uiFlags = UI_RIGHT;
 
     ui_sortdemos_changed(ui_sortdemos);
 
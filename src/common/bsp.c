@@ -25,6 +25,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "common/cmd.h"
 #include "common/common.h"
 #include "common/files.h"
+#include "common/loadprof.h"
 #include "common/bsp.h"
 #include "common/math.h"
 #include "common/utils.h"
@@ -976,11 +977,16 @@ int BSP_Load(const char *name, bsp_t **bsp_p)
         return Q_ERR_SUCCESS;
     }
 
+    LoadProf_Begin("BSP_Load", name);
+
     //
     // load the file
     //
+    LoadProf_Begin("BSP file", name);
     filelen = FS_LoadFile(name, (void **)&buf);
+    LoadProf_End();
     if (!buf) {
+        LoadProf_End();
         return filelen;
     }
 
@@ -1034,6 +1040,7 @@ int BSP_Load(const char *name, bsp_t **bsp_p)
     bsp->checksum = LittleLong(Com_BlockChecksum(buf, filelen));
 
     // load all lumps
+    LoadProf_Begin("BSP decode", name);
     for (info = bsp_lumps; info->load; info++) {
         ret = info->load(bsp, lumpdata[info->lump], lumpcount[info->lump]);
         if (ret) {
@@ -1052,19 +1059,23 @@ int BSP_Load(const char *name, bsp_t **bsp_p)
     }
 
     Hunk_End(&bsp->hunk);
+    LoadProf_End();
 
     List_Append(&bsp_cache, &bsp->entry);
 
     FS_FreeFile(buf);
+    LoadProf_End();
 
     *bsp_p = bsp;
     return Q_ERR_SUCCESS;
 
 fail1:
+    LoadProf_End();
     Hunk_Free(&bsp->hunk);
     Z_Free(bsp);
 fail2:
     FS_FreeFile(buf);
+    LoadProf_End();
     return ret;
 }
 
@@ -31,6 +31,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "common/field.h"
 #include "common/fifo.h"
 #include "common/files.h"
+#include "common/loadprof.h"
 #include "common/math.h"
 #include "common/mdfour.h"
 #include "common/msg.h"
@@ -520,6 +521,10 @@ void Com_Error(error_type_t code, const char *fmt, ...)
     // reset Com_Printf recursion level
     com_printEntered = 0;
 
+    // close any speedrun load phases interrupted by the error
+    SpeedrunAbortLoad();
+    LoadProf_Abort();
+
     if (code == ERR_DISCONNECT || code == ERR_RECONNECT) {
         Com_WPrintf("%s\n", com_errorMsg);
         SV_Shutdown(va("Server was killed: %s\n", com_errorMsg), code);
@@ -993,6 +998,9 @@ void Qcommon_Init(int argc, char **argv)
 
     Cmd_AddCommand("lasterror", Com_LastError_f);
 
+    SpeedrunInitTimer();
+    LoadProf_Init();
+
     Cmd_AddCommand("quit", Com_Quit_f);
 #if !USE_CLIENT
     Cmd_AddCommand("recycle", Com_Recycle_f);
@@ -1056,8 +1064,6 @@ void Qcommon_Frame(void)
     static unsigned remaining;
     static float frac;
 
-    SpeedrunUpdateTimer();
-
     if (setjmp(com_abortframe)) {
         return;            // an ERR_DROP was thrown
     }
@@ -0,0 +1,404 @@
+/*
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+//
+// loadprof.c -- hierarchical level load profiler
+//
+
+#include "shared/shared.h"
+#include "common/cmd.h"
+#include "common/common.h"
+#include "common/cvar.h"
+#include "common/files.h"
+#include "common/loadprof.h"
+#include "common/zone.h"
+#include "system/system.h"
+
+#define LP_MAX_ZONES    8192
+#define LP_MAX_DEPTH    32
+#define LP_MAX_SLOWEST  16
+
+typedef struct {
+    const char  *name;
+    char        detail[MAX_QPATH];
+    uint64_t    start, end;
+    int         parent;
+} lpzone_t;
+
+// aggregated zone tree used for printing
+typedef struct {
+    const char  *name;
+    int         child, lastchild, sibling;
+    unsigned    count;
+    uint64_t    total, self;
+} lpnode_t;
+
+static cvar_t       *com_loadprof;
+
+static lpzone_t     *lp_zones;
+static int          lp_numzones;
+static int          lp_dropped;
+
+static int          lp_stack[LP_MAX_DEPTH];
+static int          lp_depth;
+static int          lp_overflow;
+
+static bool         lp_active;
+static char         lp_mapname[MAX_QPATH];
+static uint64_t     lp_start, lp_end;
+
+bool LoadProf_Active(void)
+{
+    return lp_active;
+}
+
+/*
+==============
+LoadProf_BeginLevel
+
+Discards any previous profile and starts recording a new one.
+==============
+*/
+void LoadProf_BeginLevel(const char *mapname)
+{
+    lp_active = false;
+
+    if (!com_loadprof || !com_loadprof->integer)
+        return;
+
+    if (!lp_zones)
+        lp_zones = Z_Malloc(sizeof(*lp_zones) * LP_MAX_ZONES);
+
+    lp_numzones = 0;
+    lp_dropped = 0;
+    lp_depth = 0;
+    lp_overflow = 0;
+    lp_active = true;
+    Q_strlcpy(lp_mapname, mapname, sizeof(lp_mapname));
+    lp_start = lp_end = Sys_Microseconds();
+}
+
+void LoadProf_Begin(const char *name, const char *detail)
+{
+    lpzone_t    *z;
+    int         index;
+
+    if (!lp_active)
+        return;
+
+    if (lp_depth == LP_MAX_DEPTH) {
+        lp_overflow++;
+        lp_dropped++;
+        return;
+    }
+
+    if (lp_numzones == LP_MAX_ZONES) {
+        lp_stack[lp_depth++] = -1;
+        lp_dropped++;
+        return;
+    }
+
+    index = lp_numzones++;
+    z = &lp_zones[index];
+    z->name = name;
+    if (detail)
+        Q_strlcpy(z->detail, detail, sizeof(z->detail));
+    else
+        z->detail[0] = 0;
+    z->parent = lp_depth ? lp_stack[lp_depth - 1] : -1;
+    z->end = 0;
+    z->start = Sys_Microseconds();
+
+    lp_stack[lp_depth++] = index;
+}
+
+void LoadProf_End(void)
+{
+    uint64_t    now;
+    int         index;
+
+    if (!lp_active)
+        return;
+
+    if (lp_overflow) {
+        lp_overflow--;
+        return;
+    }
+
+    // zones opened before the level began are not on the stack
+    if (!lp_depth)
+        return;
+
+    now = Sys_Microseconds();
+    index = lp_stack[--lp_depth];
+    if (index >= 0)
+        lp_zones[index].end = now;
+}
+
+static uint64_t LP_ZoneTime(const lpzone_t *z)
+{
+    return (z->end ? z->end : lp_end) - z->start;
+}
+
+static lpnode_t *LP_BuildTree(void)
+{
+    lpnode_t    *nodes, *n, *p;
+    int         *map;
+    int         i, j, parent, numnodes;
+    uint64_t    time;
+
+    // node 0 is the root
+    nodes = Z_Mallocz(sizeof(*nodes) * (lp_numzones + 1));
+    map = Z_Malloc(sizeof(*map) * (lp_numzones + 1));
+    numnodes = 1;
+
+    // zones are stored in begin order, so parents come before children
+    for (i = 0; i < lp_numzones; i++) {
+        const lpzone_t *z = &lp_zones[i];
+
+        parent = z->parent < 0 ? 0 : map[z->parent];
+        p = &nodes[parent];
+
+        for (j = p->child; j; j = nodes[j].sibling)
+            if (!strcmp(nodes[j].name, z->name))
+                break;
+
+        if (!j) {
+            j = numnodes++;
+            nodes[j].name = z->name;
+            if (p->lastchild)
+                nodes[p->lastchild].sibling = j;
+            else
+                p->child = j;
+            p->lastchild = j;
+        }
+
+        map[i] = j;
+
+        time = LP_ZoneTime(z);
+        n = &nodes[j];
+        n->count++;
+        n->total += time;
+        n->self += time;
+        if (parent)
+            p->self -= time;
+    }
+
+    Z_Free(map);
+    return nodes;
+}
+
+static void LP_PrintNode(const lpnode_t *nodes, int index, int depth)
+{
+    const lpnode_t *n;
+    int indent = min(depth * 2, 24);
+
+    for (; index; index = n->sibling) {
+        n = &nodes[index];
+        Com_Printf("%*s%-*s %6u %10.2f %10.2f\n", indent, "", 32 - indent,
+                   n->name, n->count, n->total * 1e-3, n->self * 1e-3);
+        LP_PrintNode(nodes, n->child, depth + 1);
+    }
+}
+
+static int LP_SlowestCmp(const void *p1, const void *p2)
+{
+    uint64_t a = LP_ZoneTime(*(const lpzone_t **)p1);
+    uint64_t b = LP_ZoneTime(*(const lpzone_t **)p2);
+
+    if (a > b)
+        return -1;
+    if (a < b)
+        return 1;
+    return 0;
+}
+
+static void LP_PrintSlowest(void)
+{
+    const lpzone_t  **sorted;
+    int             i, count;
+
+    sorted = Z_Malloc(sizeof(*sorted) * lp_numzones);
+    for (i = count = 0; i < lp_numzones; i++)
+        if (lp_zones[i].detail[0])
+            sorted[count++] = &lp_zones[i];
+
+    qsort(sorted, count, sizeof(sorted[0]), LP_SlowestCmp);
+
+    Com_Printf("\nslowest                                 msec\n"
+               "-------------------------------- ----------\n");
+    for (i = 0; i < count && i < LP_MAX_SLOWEST; i++)
+        Com_Printf("%-32s %10.2f  %s\n", sorted[i]->name,
+                   LP_ZoneTime(sorted[i]) * 1e-3, sorted[i]->detail);
+
+    Z_Free(sorted);
+}
+
+static void LP_Print(void)
+{
+    lpnode_t    *nodes;
+
+    if (!lp_numzones || lp_active) {
+        Com_Printf("No load profile recorded.\n");
+        return;
+    }
+
+    Com_Printf("Load profile for %s: %.2f msec, %d zones",
+               lp_mapname, (lp_end - lp_start) * 1e-3, lp_numzones);
+    if (lp_dropped)
+        Com_Printf(", %d dropped", lp_dropped);
+    Com_Printf("\n\n"
+               "zone                              count       msec  self msec\n"
+               "-------------------------------- ------ ---------- ----------\n");
+
+    nodes = LP_BuildTree();
+    LP_PrintNode(nodes, nodes[0].child, 0);
+    Z_Free(nodes);
+
+    if (com_loadprof->integer > 1)
+        LP_PrintSlowest();
+}
+
+/*
+==============
+LoadProf_EndLevel
+
+Stops recording and prints the breakdown.
+==============
+*/
+void LoadProf_EndLevel(void)
+{
+    if (!lp_active)
+        return;
+
+    lp_end = Sys_Microseconds();
+    lp_active = false;
+
+    LP_Print();
+}
+
+/*
+==============
+LoadProf_Abort
+
+Called on errors. Discards the profile being recorded, since the zones
+interrupted by the error will never be closed.
+==============
+*/
+void LoadProf_Abort(void)
+{
+    if (!lp_active)
+        return;
+
+    lp_active = false;
+    lp_numzones = 0;
+    lp_dropped = 0;
+    lp_mapname[0] = 0;
+    lp_start = lp_end = 0;
+}
+
+static void LP_WriteString(qhandle_t f, const char *s)
+{
+    char    buffer[MAX_QPATH * 2];
+    char    *p = buffer;
+
+    for (; *s && p < buffer + sizeof(buffer) - 7; s++) {
+        if (*s == '"' || *s == '\\') {
+            *p++ = '\\';
+            *p++ = *s;
+        } else if (Q_isprint(*s)) {
+            *p++ = *s;
+        } else {
+            p += Q_snprintf(p, 7, "\\u%04x", (byte)*s);
+        }
+    }
+    *p = 0;
+
+    FS_FPrintf(f, "\"%s\"", buffer);
+}
+
+/*
+==============
+LP_WriteTrace
+
+Writes the last profile in Chrome trace event format, suitable for
+chrome://tracing or Perfetto.
+==============
+*/
+static void LP_WriteTrace(const char *arg)
+{
+    char        name[MAX_OSPATH];
+    qhandle_t   f;
+    lpzone_t    *z;
+    int         i;
+
+    f = FS_EasyOpenFile(name, sizeof(name), FS_MODE_WRITE | FS_FLAG_TEXT,
+                        "loadprof/", arg, ".json");
+    if (!f) {
+        return;
+    }
+
+    FS_FPrintf(f, "{\"traceEvents\":[\n");
+    FS_FPrintf(f, "{\"name\":\"level\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+               "\"ts\":0,\"dur\":%"PRIu64",\"args\":{\"map\":",
+               lp_end - lp_start);
+    LP_WriteString(f, lp_mapname);
+    FS_FPrintf(f, "}}");
+
+    for (i = 0, z = lp_zones; i < lp_numzones; i++, z++) {
+        FS_FPrintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                   "\"ts\":%"PRIu64",\"dur\":%"PRIu64, z->name,
+                   z->start - lp_start, LP_ZoneTime(z));
+        if (z->detail[0]) {
+            FS_FPrintf(f, ",\"args\":{\"detail\":");
+            LP_WriteString(f, z->detail);
+            FS_FPrintf(f, "}");
+        }
+        FS_FPrintf(f, "}");
+    }
+
+    FS_FPrintf(f, "\n]}\n");
+
+    if (FS_FCloseFile(f))
+        Com_EPrintf("Error writing %s\n", name);
+    else
+        Com_Printf("Wrote load trace to %s.\n", name);
+}
+
+static void LoadProf_f(void)
+{
+    if (Cmd_Argc() > 1 && !strcmp(Cmd_Argv(1), "trace")) {
+        if (Cmd_Argc() != 3) {
+            Com_Printf("Usage: %s trace <filename>\n", Cmd_Argv(0));
+            return;
+        }
+        if (!lp_numzones || lp_active) {
+            Com_Printf("No load profile recorded.\n");
+            return;
+        }
+        LP_WriteTrace(Cmd_Argv(2));
+        return;
+    }
+
+    LP_Print();
+}
+
+void LoadProf_Init(void)
+{
+    com_loadprof = Cvar_Get("com_loadprof", "0", 0);
+
+    Cmd_AddCommand("loadprof", LoadProf_f);
+}
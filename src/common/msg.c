@@ -310,15 +310,33 @@ int MSG_WriteDeltaUsercmd(const usercmd_t *from, const usercmd_t *cmd, int versi
     return bits;
 }
 
+static inline void store_bits(byte *p, uint64_t word)
+{
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    memcpy(p, &word, sizeof(word));
+#else
+    int i;
+
+    for (i = 0; i < 8; i++, word >>= 8) {
+        p[i] = word & 255;
+    }
+#endif
+}
+
 /*
 =============
 MSG_WriteBits
+
+Bits are packed LSB first. Value is merged with the partially written
+byte in a 64-bit word and stored at once, instead of bit by bit.
 =============
 */
 void MSG_WriteBits(int value, int bits)
 {
-    int i;
-    size_t bitpos;
+    size_t bitpos, offset, i, count;
+    unsigned shift;
+    uint64_t word;
+    byte *p;
 
     if (bits == 0 || bits < -31 || bits > 32) {
         Com_Error(ERR_FATAL, "MSG_WriteBits: bad bits: %d", bits);
@@ -349,13 +367,26 @@ void MSG_WriteBits(int value, int bits)
             break;
         }
     }
-    for (i = 0; i < bits; i++, bitpos++) {
-        if ((bitpos & 7) == 0) {
-            msg_write.data[bitpos >> 3] = 0;
+
+    offset = bitpos >> 3;
+    shift = bitpos & 7;
+    p = msg_write.data + offset;
+
+    // keep bits already written to the first byte, clear everything above
+    word = (uint64_t)((uint32_t)value & (0xffffffffU >> (32 - bits))) << shift;
+    word |= p[0] & ((1U << shift) - 1);
+
+    if (msg_write.maxsize - offset >= 8) {
+        // bytes past the new end of message are garbage anyway
+        store_bits(p, word);
+    } else {
+        count = (shift + bits + 7) >> 3;
+        for (i = 0; i < count; i++, word >>= 8) {
+            p[i] = word & 255;
         }
-        msg_write.data[bitpos >> 3] |= (value & 1) << (bitpos & 7);
-        value >>= 1;
     }
+
+    bitpos += bits;
     msg_write.bitpos = bitpos;
     msg_write.cursize = (bitpos + 7) >> 3;
 }
@@ -502,11 +533,61 @@ void MSG_PackEntity(entity_packed_t *out, const entity_state_t *in, bool short_a
     out->event = in->event;
 }
 
+// fields of a delta entity are assembled here and written to msg_write at
+// once, instead of growing the message one byte or short at a time
+#define MAX_DELTA_ENTITY_BYTES  64
+
+static inline byte *put8(byte *p, int c)
+{
+    p[0] = c & 255;
+    return p + 1;
+}
+
+static inline byte *put16(byte *p, int c)
+{
+    p[0] = c & 255;
+    p[1] = (c >> 8) & 255;
+    return p + 2;
+}
+
+static inline byte *put32(byte *p, int c)
+{
+    p[0] = c & 255;
+    p[1] = (c >> 8) & 255;
+    p[2] = (c >> 16) & 255;
+    p[3] = (c >> 24) & 255;
+    return p + 4;
+}
+
+/*
+=============
+MSG_DeltaEntityUnchanged
+
+Returns true if MSG_WriteDeltaEntity would write nothing for this pair.
+Most entities don't change between frames, so a single compare of the
+packed states (no padding) is done before checking fields one by one.
+Events and lerp/beam old origins are always sent and never match here.
+=============
+*/
+static bool MSG_DeltaEntityUnchanged(const entity_packed_t *from,
+                                     const entity_packed_t *to,
+                                     msgEsFlags_t          flags)
+{
+    if (flags & (MSG_ES_FORCE | MSG_ES_NEWENTITY))
+        return false;
+
+    if (to->event || (to->renderfx & (RF_FRAMELERP | RF_BEAM)))
+        return false;
+
+    return !memcmp(from, to, sizeof(*to));
+}
+
 void MSG_WriteDeltaEntity(const entity_packed_t *from,
                           const entity_packed_t *to,
                           msgEsFlags_t          flags)
 {
     uint32_t    bits, mask;
+    byte        buffer[MAX_DELTA_ENTITY_BYTES], *p = buffer;
 
     if (!to) {
         if (!from)
@@ -519,15 +600,16 @@ void MSG_WriteDeltaEntity(const entity_packed_t *from,
         if (from->number & 0xff00)
             bits |= U_NUMBER16 | U_MOREBITS1;
 
-        MSG_WriteByte(bits & 255);
+        p = put8(p, bits & 255);
         if (bits & 0x0000ff00)
-            MSG_WriteByte((bits >> 8) & 255);
+            p = put8(p, (bits >> 8) & 255);
 
         if (bits & U_NUMBER16)
-            MSG_WriteShort(from->number);
+            p = put16(p, from->number);
         else
-            MSG_WriteByte(from->number);
+            p = put8(p, from->number);
 
+        MSG_WriteData(buffer, p - buffer);
         return; // remove entity
     }
 
@@ -537,6 +619,9 @@ void MSG_WriteDeltaEntity(const entity_packed_t *from,
     if (!from)
         from = &nullEntityState;
 
+    if (MSG_DeltaEntityUnchanged(from, to, flags))
+        return;     // nothing to send!
+
 // send an update
     bits = 0;
 
@@ -664,100 +749,102 @@ void MSG_WriteDeltaEntity(const entity_packed_t *from,
     else if (bits & 0x0000ff00)
         bits |= U_MOREBITS1;
 
-    MSG_WriteByte(bits & 255);
+    p = put8(p, bits & 255);
 
     if (bits & 0xff000000) {
-        MSG_WriteByte((bits >> 8) & 255);
-        MSG_WriteByte((bits >> 16) & 255);
-        MSG_WriteByte((bits >> 24) & 255);
+        p = put8(p, (bits >> 8) & 255);
+        p = put8(p, (bits >> 16) & 255);
+        p = put8(p, (bits >> 24) & 255);
     } else if (bits & 0x00ff0000) {
-        MSG_WriteByte((bits >> 8) & 255);
-        MSG_WriteByte((bits >> 16) & 255);
+        p = put8(p, (bits >> 8) & 255);
+        p = put8(p, (bits >> 16) & 255);
     } else if (bits & 0x0000ff00) {
-        MSG_WriteByte((bits >> 8) & 255);
+        p = put8(p, (bits >> 8) & 255);
     }
 
     //----------
 
     if (bits & U_NUMBER16)
-        MSG_WriteShort(to->number);
+        p = put16(p, to->number);
     else
-        MSG_WriteByte(to->number);
+        p = put8(p, to->number);
 
     if (bits & U_MODEL)
-        MSG_WriteByte(to->modelindex);
+        p = put8(p, to->modelindex);
     if (bits & U_MODEL2)
-        MSG_WriteByte(to->modelindex2);
+        p = put8(p, to->modelindex2);
     if (bits & U_MODEL3)
-        MSG_WriteByte(to->modelindex3);
+        p = put8(p, to->modelindex3);
     if (bits & U_MODEL4)
-        MSG_WriteByte(to->modelindex4);
+        p = put8(p, to->modelindex4);
 
     if (bits & U_FRAME8)
-        MSG_WriteByte(to->frame);
+        p = put8(p, to->frame);
     else if (bits & U_FRAME16)
-        MSG_WriteShort(to->frame);
+        p = put16(p, to->frame);
 
     if ((bits & (U_SKIN8 | U_SKIN16)) == (U_SKIN8 | U_SKIN16))  //used for laser colors
-        MSG_WriteLong(to->skinnum);
+        p = put32(p, to->skinnum);
     else if (bits & U_SKIN8)
-        MSG_WriteByte(to->skinnum);
+        p = put8(p, to->skinnum);
     else if (bits & U_SKIN16)
-        MSG_WriteShort(to->skinnum);
+        p = put16(p, to->skinnum);
 
     if ((bits & (U_EFFECTS8 | U_EFFECTS16)) == (U_EFFECTS8 | U_EFFECTS16))
-        MSG_WriteLong(to->effects);
+        p = put32(p, to->effects);
     else if (bits & U_EFFECTS8)
-        MSG_WriteByte(to->effects);
+        p = put8(p, to->effects);
     else if (bits & U_EFFECTS16)
-        MSG_WriteShort(to->effects);
+        p = put16(p, to->effects);
 
     if ((bits & (U_RENDERFX8 | U_RENDERFX16)) == (U_RENDERFX8 | U_RENDERFX16))
-        MSG_WriteLong(to->renderfx);
+        p = put32(p, to->renderfx);
     else if (bits & U_RENDERFX8)
-        MSG_WriteByte(to->renderfx);
+        p = put8(p, to->renderfx);
     else if (bits & U_RENDERFX16)
-        MSG_WriteShort(to->renderfx);
+        p = put16(p, to->renderfx);
 
     if (bits & U_ORIGIN1)
-        MSG_WriteShort(to->origin[0]);
+        p = put16(p, to->origin[0]);
     if (bits & U_ORIGIN2)
-        MSG_WriteShort(to->origin[1]);
+        p = put16(p, to->origin[1]);
     if (bits & U_ORIGIN3)
-        MSG_WriteShort(to->origin[2]);
+        p = put16(p, to->origin[2]);
 
     if ((flags & MSG_ES_SHORTANGLES) && (bits & U_ANGLE16)) {
         if (bits & U_ANGLE1)
-            MSG_WriteShort(to->angles[0]);
+            p = put16(p, to->angles[0]);
         if (bits & U_ANGLE2)
-            MSG_WriteShort(to->angles[1]);
+            p = put16(p, to->angles[1]);
         if (bits & U_ANGLE3)
-            MSG_WriteShort(to->angles[2]);
+            p = put16(p, to->angles[2]);
     } else {
         if (bits & U_ANGLE1)
-            MSG_WriteByte(to->angles[0] >> 8);
+            p = put8(p, to->angles[0] >> 8);
         if (bits & U_ANGLE2)
-            MSG_WriteByte(to->angles[1] >> 8);
+            p = put8(p, to->angles[1] >> 8);
         if (bits & U_ANGLE3)
-            MSG_WriteByte(to->angles[2] >> 8);
+            p = put8(p, to->angles[2] >> 8);
     }
 
     if (bits & U_OLDORIGIN) {
-        MSG_WriteShort(to->old_origin[0]);
-        MSG_WriteShort(to->old_origin[1]);
-        MSG_WriteShort(to->old_origin[2]);
+        p = put16(p, to->old_origin[0]);
+        p = put16(p, to->old_origin[1]);
+        p = put16(p, to->old_origin[2]);
     }
 
     if (bits & U_SOUND)
-        MSG_WriteByte(to->sound);
+        p = put8(p, to->sound);
     if (bits & U_EVENT)
-        MSG_WriteByte(to->event);
+        p = put8(p, to->event);
     if (bits & U_SOLID) {
         if (flags & MSG_ES_LONGSOLID)
-            MSG_WriteLong(to->solid);
+            p = put32(p, to->solid);
         else
-            MSG_WriteShort(to->solid);
+            p = put16(p, to->solid);
     }
+
+    MSG_WriteData(buffer, p - buffer);
 }
 
 static inline int OFFSET2CHAR(float x)
@@ -1734,10 +1821,29 @@ void MSG_ReadDeltaUsercmd_Hacked(const usercmd_t *from, usercmd_t *to)
     to->lightlevel = MSG_ReadByte();
 }
 
+static inline uint64_t load_bits(const byte *p)
+{
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    uint64_t word;
+
+    memcpy(&word, p, sizeof(word));
+    return word;
+#else
+    uint64_t word = 0;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        word |= (uint64_t)p[i] << (i * 8);
+    }
+    return word;
+#endif
+}
+
 int MSG_ReadBits(int bits)
 {
     int i, value;
-    size_t bitpos;
+    size_t bitpos, offset;
+    uint64_t word;
     bool sgn;
 
     if (bits == 0 || bits < -31 || bits > 32) {
@@ -1771,11 +1877,19 @@ int MSG_ReadBits(int bits)
         sgn = true;
     }
 
-    value = 0;
-    for (i = 0; i < bits; i++, bitpos++) {
-        unsigned get = (msg_read.data[bitpos >> 3] >> (bitpos & 7)) & 1;
-        value |= get << i;
+    // fetch the whole word at once, bytes past the end of buffer read as zero
+    offset = bitpos >> 3;
+    if (offset + 8 <= msg_read.maxsize) {
+        word = load_bits(msg_read.data + offset);
+    } else {
+        word = 0;
+        for (i = 0; i < 8 && offset + i < msg_read.maxsize; i++) {
+            word |= (uint64_t)msg_read.data[offset + i] << (i * 8);
+        }
     }
+    value = (word >> (bitpos & 7)) & (0xffffffffU >> (32 - bits));
+
+    bitpos += bits;
     msg_read.bitpos = bitpos;
     msg_read.readcount = (bitpos + 7) >> 3;
 
@@ -81,6 +81,9 @@ then a packet only needs to be delivered if there is something in the
 unacknowledged reliable
 */
 
+// sequence numbers, qport and fragment offset
+#define NETCHAN_HEADER_SIZE     16
+
 #ifdef _DEBUG
 static cvar_t       *showpackets;
 static cvar_t       *showdrop;
@@ -99,6 +102,8 @@ cvar_t      *net_qport;
 cvar_t      *net_maxmsglen;
 cvar_t      *net_chantype;
 
+netchan_stats_t     netchan_stats;
+
 // allow either 0 (no hard limit), or an integer between 512 and 4086
 static void net_maxmsglen_changed(cvar_t *self)
 {
@@ -171,6 +176,50 @@ static size_t NetchanOld_TransmitNextFragment(netchan_t *netchan)
     return 0;
 }
 
+// outgoing packet, sent as header followed by references to the
+// reliable and unreliable data
+typedef struct {
+    net_iovec_t iov[NET_MAX_IOVECS];
+    int         iovcnt;
+    size_t      cursize;
+} packet_t;
+
+static void add_packet_data(packet_t *packet, const void *data, size_t len)
+{
+    if (!len)
+        return;
+
+    packet->iov[packet->iovcnt].data = data;
+    packet->iov[packet->iovcnt].len = len;
+    packet->iovcnt++;
+    packet->cursize += len;
+}
+
+// starts sending the current message as the new reliable one; buffers are
+// swapped instead of copying the message out
+static void transfer_reliable(netchan_t *netchan, byte **message_buf, byte **reliable_buf)
+{
+    byte *tmp = *reliable_buf;
+
+    *reliable_buf = *message_buf;
+    *message_buf = tmp;
+
+    netchan->reliable_length = netchan->message.cursize;
+    netchan->message.data = tmp;
+    netchan->message.cursize = 0;
+}
+
+// remote acks the newest packet it got from us, so sequences an advancing
+// ack jumps over are outgoing packets it most likely never received
+static void update_acknowledged(netchan_t *netchan, int sequence_ack)
+{
+    if (sequence_ack > netchan->incoming_acknowledged) {
+        netchan->total_acked++;
+        netchan->total_skipped += sequence_ack - netchan->incoming_acknowledged - 1;
+    }
+    netchan->incoming_acknowledged = sequence_ack;
+}
+
 /*
 ===============
 NetchanOld_Transmit
@@ -185,7 +234,8 @@ static size_t NetchanOld_Transmit(netchan_t *netchan, size_t length, const void
 {
     netchan_old_t *chan = (netchan_old_t *)netchan;
     sizebuf_t   send;
-    byte        send_buf[MAX_PACKETLEN];
+    byte        send_buf[NETCHAN_HEADER_SIZE];
+    packet_t    packet;
     bool        send_reliable;
     uint32_t    w1, w2;
     int         i;
@@ -204,15 +254,13 @@ static size_t NetchanOld_Transmit(netchan_t *netchan, size_t length, const void
     if (netchan->incoming_acknowledged > chan->last_reliable_sequence &&
         chan->incoming_reliable_acknowledged != chan->reliable_sequence) {
         send_reliable = true;
+        netchan_stats.reliable_resends++;
     }
 
-// if the reliable transmit buffer is empty, copy the current message out
+// if the reliable transmit buffer is empty, transfer the current message
     if (!netchan->reliable_length && netchan->message.cursize) {
         send_reliable = true;
-        memcpy(chan->reliable_buf, chan->message_buf,
-               netchan->message.cursize);
-        netchan->reliable_length = netchan->message.cursize;
-        netchan->message.cursize = 0;
+        transfer_reliable(netchan, &chan->message_buf, &chan->reliable_buf);
         chan->reliable_sequence ^= 1;
     }
 
@@ -238,21 +286,25 @@ static size_t NetchanOld_Transmit(netchan_t *netchan, size_t length, const void
     }
 #endif
 
-// copy the reliable message to the packet first
+    packet.iovcnt = 0;
+    packet.cursize = 0;
+    add_packet_data(&packet, send.data, send.cursize);
+
+// reference the reliable message first
     if (send_reliable) {
-        SZ_Write(&send, chan->reliable_buf, netchan->reliable_length);
+        add_packet_data(&packet, chan->reliable_buf, netchan->reliable_length);
         chan->last_reliable_sequence = netchan->outgoing_sequence;
     }
 
 // add the unreliable part if space is available
-    if (send.maxsize - send.cursize >= length)
-        SZ_Write(&send, data, length);
+    if (MAX_PACKETLEN - packet.cursize >= length)
+        add_packet_data(&packet, data, length);
     else
         Com_WPrintf("%s: dumped unreliable\n",
                     NET_AdrToString(&netchan->remote_address));
 
     SHOWPACKET("send %4"PRIz" : s=%d ack=%d rack=%d",
-               send.cursize,
+               packet.cursize,
                netchan->outgoing_sequence,
                netchan->incoming_sequence,
                chan->incoming_reliable_sequence);
@@ -263,15 +315,15 @@ static size_t NetchanOld_Transmit(netchan_t *netchan, size_t length, const void
 
     // send the datagram
     for (i = 0; i < numpackets; i++) {
-        NET_SendPacket(netchan->sock, send.data, send.cursize,
-                       &netchan->remote_address);
+        NET_SendPacketv(netchan->sock, packet.iov, packet.iovcnt,
+                        &netchan->remote_address);
     }
 
     netchan->outgoing_sequence++;
     netchan->reliable_ack_pending = false;
     netchan->last_sent = com_localTime;
 
-    return send.cursize * numpackets;
+    return packet.cursize * numpackets;
 }
 
 /*
@@ -353,7 +405,7 @@ static bool NetchanOld_Process(netchan_t *netchan)
 // if this message contains a reliable message, bump incoming_reliable_sequence
 //
     netchan->incoming_sequence = sequence;
-    netchan->incoming_acknowledged = sequence_ack;
+    update_acknowledged(netchan, sequence_ack);
     if (reliable_message) {
         netchan->reliable_ack_pending = true;
         chan->incoming_reliable_sequence ^= 1;
@@ -429,6 +481,47 @@ static netchan_t *NetchanOld_Setup(netsrc_t sock, const netadr_t *adr,
 // ============================================================================
 
 
+#define FRAGMENT_POOL_SIZE  8
+
+// free fragment buffers, shared by all new style channels
+static byte     *fragment_pool[FRAGMENT_POOL_SIZE];
+static int      fragment_pool_count;
+
+static void get_fragment_buf(sizebuf_t *buf, uint32_t tag)
+{
+    byte *data;
+
+    if (buf->data)
+        return;
+
+    if (fragment_pool_count)
+        data = fragment_pool[--fragment_pool_count];
+    else
+        data = Z_Malloc(MAX_MSGLEN);
+
+    SZ_TagInit(buf, data, MAX_MSGLEN, tag);
+}
+
+// assembled message msg_read currently points into. msg_read is reset
+// for every packet, so it goes back to the pool when the next one comes in
+static byte     *fragment_read;
+
+static void release_fragment_data(byte *data)
+{
+    if (fragment_pool_count < FRAGMENT_POOL_SIZE)
+        fragment_pool[fragment_pool_count++] = data;
+    else
+        Z_Free(data);
+}
+
+static void put_fragment_buf(sizebuf_t *buf)
+{
+    if (buf->data)
+        release_fragment_data(buf->data);
+
+    SZ_TagInit(buf, NULL, 0, buf->tag);
+}
+
 /*
 ===============
 NetchanNew_TransmitNextFragment
@@ -438,11 +531,12 @@ static size_t NetchanNew_TransmitNextFragment(netchan_t *netchan)
 {
     netchan_new_t *chan = (netchan_new_t *)netchan;
     sizebuf_t   send;
-    byte        send_buf[MAX_PACKETLEN];
+    byte        send_buf[NETCHAN_HEADER_SIZE];
+    packet_t    packet;
     bool        send_reliable;
     uint32_t    w1, w2;
     uint16_t    offset;
-    size_t      fragment_length;
+    size_t      fragment_offset, fragment_length, total_length, reliable_length;
     bool        more_fragments;
 
     send_reliable = netchan->reliable_length ? true : false;
@@ -465,54 +559,72 @@ static size_t NetchanNew_TransmitNextFragment(netchan_t *netchan)
     }
 #endif
 
-    fragment_length = chan->fragment_out.cursize - chan->fragment_out.readcount;
+    // fragmented message is reliable_buf contents followed by fragment_out
+    // contents, fragment_out.readcount is offset into the whole message
+    reliable_length = chan->fragment_reliable;
+    total_length = reliable_length + chan->fragment_out.cursize;
+    fragment_offset = chan->fragment_out.readcount;
+
+    fragment_length = total_length - fragment_offset;
     if (fragment_length > netchan->maxpacketlen) {
         fragment_length = netchan->maxpacketlen;
     }
 
     more_fragments = true;
-    if (chan->fragment_out.readcount + fragment_length ==
-        chan->fragment_out.cursize) {
+    if (fragment_offset + fragment_length == total_length) {
         more_fragments = false;
     }
 
     // write fragment offset
-    offset = (chan->fragment_out.readcount & 0x7FFF) |
-             (more_fragments << 15);
+    offset = (fragment_offset & 0x7FFF) | (more_fragments << 15);
     SZ_WriteShort(&send, offset);
 
-    // write fragment contents
-    SZ_Write(&send, chan->fragment_out.data + chan->fragment_out.readcount,
-             fragment_length);
+    // reference fragment contents
+    packet.iovcnt = 0;
+    packet.cursize = 0;
+    add_packet_data(&packet, send.data, send.cursize);
+    if (fragment_offset < reliable_length) {
+        add_packet_data(&packet, chan->reliable_buf + fragment_offset,
+                        min(fragment_length, reliable_length - fragment_offset));
+    }
+    if (fragment_offset + fragment_length > reliable_length) {
+        size_t start = max(fragment_offset, reliable_length) - reliable_length;
+
+        add_packet_data(&packet, chan->fragment_out.data + start,
+                        fragment_offset + fragment_length - reliable_length - start);
+    }
 
     SHOWPACKET("send %4"PRIz" : s=%d ack=%d rack=%d "
                "fragment_offset=%"PRIz" more_fragments=%d",
-               send.cursize,
+               packet.cursize,
                netchan->outgoing_sequence,
                netchan->incoming_sequence,
                chan->incoming_reliable_sequence,
-               chan->fragment_out.readcount,
+               fragment_offset,
                more_fragments);
     if (send_reliable) {
         SHOWPACKET(" reliable=%i ", chan->reliable_sequence);
     }
     SHOWPACKET("\n");
 
+    // send the datagram
+    NET_SendPacketv(netchan->sock, packet.iov, packet.iovcnt,
+                    &netchan->remote_address);
+
+    netchan_stats.fragments_sent++;
+
     chan->fragment_out.readcount += fragment_length;
     netchan->fragment_pending = more_fragments;
 
-    // if the message has been sent completely, clear the fragment buffer
+    // if the message has been sent completely, release the fragment buffer
     if (!netchan->fragment_pending) {
         netchan->outgoing_sequence++;
         netchan->last_sent = com_localTime;
-        SZ_Clear(&chan->fragment_out);
+        chan->fragment_reliable = 0;
+        put_fragment_buf(&chan->fragment_out);
     }
 
-    // send the datagram
-    NET_SendPacket(netchan->sock, send.data, send.cursize,
-                   &netchan->remote_address);
-
-    return send.cursize;
+    return packet.cursize;
 }
 
 /*
@@ -524,7 +636,8 @@ static size_t NetchanNew_Transmit(netchan_t *netchan, size_t length, const void
 {
     netchan_new_t *chan = (netchan_new_t *)netchan;
     sizebuf_t   send;
-    byte        send_buf[MAX_PACKETLEN];
+    byte        send_buf[NETCHAN_HEADER_SIZE];
+    packet_t    packet;
     bool        send_reliable;
     uint32_t    w1, w2;
     int         i;
@@ -547,31 +660,35 @@ static size_t NetchanNew_Transmit(netchan_t *netchan, size_t length, const void
     if (netchan->incoming_acknowledged > chan->last_reliable_sequence &&
         chan->incoming_reliable_acknowledged != chan->reliable_sequence) {
         send_reliable = true;
+        netchan_stats.reliable_resends++;
     }
 
-// if the reliable transmit buffer is empty, copy the current message out
+// if the reliable transmit buffer is empty, transfer the current message
     if (!netchan->reliable_length && netchan->message.cursize) {
         send_reliable = true;
-        memcpy(chan->reliable_buf, chan->message_buf,
-               netchan->message.cursize);
-        netchan->reliable_length = netchan->message.cursize;
-        netchan->message.cursize = 0;
+        transfer_reliable(netchan, &chan->message_buf, &chan->reliable_buf);
         chan->reliable_sequence ^= 1;
     }
 
     if (length > netchan->maxpacketlen || (send_reliable &&
                                            (netchan->reliable_length + length > netchan->maxpacketlen))) {
+        // reliable part is sent straight from reliable_buf, which
+        // is not touched until all fragments are sent
         if (send_reliable) {
             chan->last_reliable_sequence = netchan->outgoing_sequence;
-            SZ_Write(&chan->fragment_out, chan->reliable_buf,
-                     netchan->reliable_length);
+            chan->fragment_reliable = netchan->reliable_length;
         }
         // add the unreliable part if space is available
-        if (chan->fragment_out.maxsize - chan->fragment_out.cursize >= length)
-            SZ_Write(&chan->fragment_out, data, length);
-        else
+        if (MAX_MSGLEN - chan->fragment_reliable >= length) {
+            if (length) {
+                get_fragment_buf(&chan->fragment_out, SZ_NC_FRG_OUT);
+                SZ_Write(&chan->fragment_out, data, length);
+            }
+        } else {
             Com_WPrintf("%s: dumped unreliable\n",
                         NET_AdrToString(&netchan->remote_address));
+        }
+        netchan_stats.messages_fragmented++;
         return NetchanNew_TransmitNextFragment(netchan);
     }
 
@@ -592,17 +709,21 @@ static size_t NetchanNew_Transmit(netchan_t *netchan, size_t length, const void
     }
 #endif
 
-    // copy the reliable message to the packet first
+    packet.iovcnt = 0;
+    packet.cursize = 0;
+    add_packet_data(&packet, send.data, send.cursize);
+
+    // reference the reliable message first
     if (send_reliable) {
         chan->last_reliable_sequence = netchan->outgoing_sequence;
-        SZ_Write(&send, chan->reliable_buf, netchan->reliable_length);
+        add_packet_data(&packet, chan->reliable_buf, netchan->reliable_length);
     }
 
     // add the unreliable part
-    SZ_Write(&send, data, length);
+    add_packet_data(&packet, data, length);
 
     SHOWPACKET("send %4"PRIz" : s=%d ack=%d rack=%d",
-               send.cursize,
+               packet.cursize,
                netchan->outgoing_sequence,
                netchan->incoming_sequence,
                chan->incoming_reliable_sequence);
@@ -613,15 +734,15 @@ static size_t NetchanNew_Transmit(netchan_t *netchan, size_t length, const void
 
     // send the datagram
     for (i = 0; i < numpackets; i++) {
-        NET_SendPacket(netchan->sock, send.data, send.cursize,
-                       &netchan->remote_address);
+        NET_SendPacketv(netchan->sock, packet.iov, packet.iovcnt,
+                        &netchan->remote_address);
     }
 
     netchan->outgoing_sequence++;
     netchan->reliable_ack_pending = false;
     netchan->last_sent = com_localTime;
 
-    return send.cursize * numpackets;
+    return packet.cursize * numpackets;
 }
 
 /*
@@ -637,6 +758,11 @@ static bool NetchanNew_Process(netchan_t *netchan)
     uint16_t    fragment_offset;
     size_t      length;
 
+    if (fragment_read) {
+        release_fragment_data(fragment_read);
+        fragment_read = NULL;
+    }
+
 // get sequence numbers
     MSG_BeginReading();
     sequence = MSG_ReadLong();
@@ -710,21 +836,26 @@ static bool NetchanNew_Process(netchan_t *netchan)
 // parse fragment header, if any
 //
     if (fragmented_message) {
+        netchan_stats.fragments_rcvd++;
+
         if (chan->fragment_sequence != sequence) {
             // start new receive sequence
             chan->fragment_sequence = sequence;
+            get_fragment_buf(&chan->fragment_in, SZ_NC_FRG_IN);
             SZ_Clear(&chan->fragment_in);
         }
 
         if (fragment_offset < chan->fragment_in.cursize) {
             SHOWDROP("%s: out of order fragment at %i\n",
                      NET_AdrToString(&netchan->remote_address), sequence);
+            netchan_stats.fragments_dropped++;
             return false;
         }
 
         if (fragment_offset > chan->fragment_in.cursize) {
             SHOWDROP("%s: dropped fragment(s) at %i\n",
                      NET_AdrToString(&netchan->remote_address), sequence);
+            netchan_stats.fragments_dropped++;
             return false;
         }
 
@@ -732,6 +863,7 @@ static bool NetchanNew_Process(netchan_t *netchan)
         if (chan->fragment_in.cursize + length > chan->fragment_in.maxsize) {
             SHOWDROP("%s: oversize fragment at %i\n",
                      NET_AdrToString(&netchan->remote_address), sequence);
+            netchan_stats.fragments_dropped++;
             return false;
         }
 
@@ -741,15 +873,18 @@ static bool NetchanNew_Process(netchan_t *netchan)
             return false;
         }
 
-        // message has been sucessfully assembled
-        SZ_Clear(&msg_read);
-        SZ_Write(&msg_read, chan->fragment_in.data,
-                 chan->fragment_in.cursize);
-        SZ_Clear(&chan->fragment_in);
+        // message has been sucessfully assembled, read it in place
+        fragment_read = chan->fragment_in.data;
+        SZ_Init(&msg_read, fragment_read, chan->fragment_in.maxsize);
+        msg_read.cursize = chan->fragment_in.cursize;
+        SZ_TagInit(&chan->fragment_in, NULL, 0, SZ_NC_FRG_IN);
+        chan->fragment_sequence = 0;
+
+        netchan_stats.messages_reassembled++;
     }
 
     netchan->incoming_sequence = sequence;
-    netchan->incoming_acknowledged = sequence_ack;
+    update_acknowledged(netchan, sequence_ack);
 
 //
 // if this message contains a reliable message, bump incoming_reliable_sequence
@@ -777,11 +912,9 @@ NetchanNew_ShouldUpdate
 */
 static bool NetchanNew_ShouldUpdate(netchan_t *netchan)
 {
-    netchan_new_t *chan = (netchan_new_t *)netchan;
-
     if (netchan->message.cursize ||
         netchan->reliable_ack_pending ||
-        chan->fragment_out.cursize ||
+        netchan->fragment_pending ||
         com_localTime - netchan->last_sent > 1000) {
         return true;
     }
@@ -817,12 +950,11 @@ static netchan_t *NetchanNew_Setup(netsrc_t sock, const netadr_t *adr,
     netchan->TransmitNextFragment = NetchanNew_TransmitNextFragment;
     netchan->ShouldUpdate = NetchanNew_ShouldUpdate;
 
-    SZ_Init(&netchan->message, chan->message_buf,
-            sizeof(chan->message_buf));
-    SZ_TagInit(&chan->fragment_in, chan->fragment_in_buf,
-               sizeof(chan->fragment_in_buf), SZ_NC_FRG_IN);
-    SZ_TagInit(&chan->fragment_out, chan->fragment_out_buf,
-               sizeof(chan->fragment_out_buf), SZ_NC_FRG_OUT);
+    chan->message_buf = chan->reliable_bufs[0];
+    chan->reliable_buf = chan->reliable_bufs[1];
+    SZ_Init(&netchan->message, chan->message_buf, MAX_MSGLEN);
+    SZ_TagInit(&chan->fragment_in, NULL, 0, SZ_NC_FRG_IN);
+    SZ_TagInit(&chan->fragment_out, NULL, 0, SZ_NC_FRG_OUT);
 
     return netchan;
 }
@@ -865,5 +997,12 @@ Netchan_Close
 */
 void Netchan_Close(netchan_t *netchan)
 {
+    if (netchan->type == NETCHAN_NEW) {
+        netchan_new_t *chan = (netchan_new_t *)netchan;
+
+        put_fragment_buf(&chan->fragment_in);
+        put_fragment_buf(&chan->fragment_out);
+    }
+
     Z_Free(netchan);
 }
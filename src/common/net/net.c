@@ -28,6 +28,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "common/files.h"
 #endif
 #include "common/msg.h"
+#include "common/net/chan.h"
 #include "common/net/net.h"
 #include "common/protocol.h"
 #include "common/zone.h"
@@ -525,6 +526,13 @@ static void NET_Stats_f(void)
 #endif
     Com_Printf("Current upload rate: %"PRIz" bytes/sec\n", net_rate_up);
     Com_Printf("Current download rate: %"PRIz" bytes/sec\n", net_rate_dn);
+    Com_Printf("Fragments sent: %"PRIu64" (%"PRIu64" messages, %"PRIu64" fragments/sec)\n",
+               netchan_stats.fragments_sent, netchan_stats.messages_fragmented,
+               netchan_stats.fragments_sent / diff);
+    Com_Printf("Fragments rcvd: %"PRIu64" (%"PRIu64" messages, %"PRIu64" dropped)\n",
+               netchan_stats.fragments_rcvd, netchan_stats.messages_reassembled,
+               netchan_stats.fragments_dropped);
+    Com_Printf("Reliable retransmits: %"PRIu64"\n", netchan_stats.reliable_resends);
 }
 
 static size_t NET_UpRate_m(char *buffer, size_t size)
@@ -918,8 +926,50 @@ NET_SendPacket
 bool NET_SendPacket(netsrc_t sock, const void *data,
                     size_t len, const netadr_t *to)
 {
-    int ret;
+    net_iovec_t iov = { data, len };
+
+    return NET_SendPacketv(sock, &iov, 1, to);
+}
+
+#if USE_CLIENT || (defined _DEBUG)
+// flattens packet for consumers that need a contiguous copy
+static size_t gather_packet(byte *buf, const net_iovec_t *iov, int iovcnt)
+{
+    size_t len = 0;
+    int i;
+
+    for (i = 0; i < iovcnt; i++) {
+        memcpy(buf + len, iov[i].data, iov[i].len);
+        len += iov[i].len;
+    }
+
+    return len;
+}
+#endif
+
+/*
+=============
+NET_SendPacketv
+
+Sends a packet made of several pieces. UDP packets are handed to the
+socket as is, so the caller doesn't need to assemble them first.
+=============
+*/
+bool NET_SendPacketv(netsrc_t sock, const net_iovec_t *iov,
+                     int iovcnt, const netadr_t *to)
+{
+    size_t len;
+    int i, ret;
     qsocket_t s;
+#if USE_CLIENT || (defined _DEBUG)
+    byte buf[MAX_PACKETLEN];
+#endif
+
+    if (iovcnt < 1 || iovcnt > NET_MAX_IOVECS)
+        Com_Error(ERR_FATAL, "%s: bad iovcnt", __func__);
+
+    for (i = len = 0; i < iovcnt; i++)
+        len += iov[i].len;
 
     if (len == 0)
         return false;
@@ -935,7 +985,12 @@ bool NET_SendPacket(netsrc_t sock, const void *data,
         return false;
 #if USE_CLIENT
     case NA_LOOPBACK:
-        return NET_SendLoopPacket(sock, data, len, to);
+        if (iovcnt == 1)
+            return NET_SendLoopPacket(sock, iov->data, len, to);
+        return NET_SendLoopPacket(sock, buf, gather_packet(buf, iov, iovcnt), to);
+#else
+    case NA_LOOPBACK:
+        return false;   // nobody listens, e.g. replay clients
 #endif
     case NA_IP:
     case NA_BROADCAST:
@@ -951,7 +1006,7 @@ bool NET_SendPacket(netsrc_t sock, const void *data,
     if (s == -1)
         return false;
 
-    ret = os_udp_send(s, data, len, to);
+    ret = os_udp_sendv(s, iov, iovcnt, to);
     if (ret == NET_AGAIN)
         return false;
 
@@ -968,7 +1023,7 @@ bool NET_SendPacket(netsrc_t sock, const void *data,
 
 #ifdef _DEBUG
     if (net_log_enable->integer)
-        NET_LogPacket(to, "UDP send", data, ret);
+        NET_LogPacket(to, "UDP send", buf, gather_packet(buf, iov, iovcnt));
 #endif
 
     net_rate_sent += ret;
@@ -134,19 +134,28 @@ static int os_udp_recv(qsocket_t sock, void *data,
     return NET_ERROR;
 }
 
-static int os_udp_send(qsocket_t sock, const void *data,
-                       size_t len, const netadr_t *to)
+static int os_udp_sendv(qsocket_t sock, const net_iovec_t *iov,
+                        int iovcnt, const netadr_t *to)
 {
     struct sockaddr_storage addr;
-    socklen_t addrlen;
+    struct iovec vec[NET_MAX_IOVECS];
+    struct msghdr msg;
     int ret;
-    int tries;
+    int i, tries;
 
-    addrlen = NET_NetadrToSockadr(to, &addr);
+    for (i = 0; i < iovcnt; i++) {
+        vec[i].iov_base = (void *)iov[i].data;
+        vec[i].iov_len = iov[i].len;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &addr;
+    msg.msg_namelen = NET_NetadrToSockadr(to, &addr);
+    msg.msg_iov = vec;
+    msg.msg_iovlen = iovcnt;
 
     for (tries = 0; tries < MAX_ERROR_RETRIES; tries++) {
-        ret = sendto(sock, data, len, 0,
-                     (struct sockaddr *)&addr, addrlen);
+        ret = sendmsg(sock, &msg, 0);
         if (ret >= 0)
             return ret;
 
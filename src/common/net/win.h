@@ -142,20 +142,25 @@ static int os_udp_recv(qsocket_t sock, void *data,
     return NET_ERROR;
 }
 
-static int os_udp_send(qsocket_t sock, const void *data,
-                       size_t len, const netadr_t *to)
+static int os_udp_sendv(qsocket_t sock, const net_iovec_t *iov,
+                        int iovcnt, const netadr_t *to)
 {
     struct sockaddr_storage addr;
+    WSABUF bufs[NET_MAX_IOVECS];
+    DWORD sent;
     int addrlen;
-    int ret;
+    int i;
 
-    addrlen = NET_NetadrToSockadr(to, &addr);
+    for (i = 0; i < iovcnt; i++) {
+        bufs[i].buf = (CHAR *)iov[i].data;
+        bufs[i].len = (ULONG)iov[i].len;
+    }
 
-    ret = sendto(sock, data, len, 0,
-                 (struct sockaddr *)&addr, addrlen);
+    addrlen = NET_NetadrToSockadr(to, &addr);
 
-    if (ret != SOCKET_ERROR)
-        return ret;
+    if (WSASendTo(sock, bufs, iovcnt, &sent, 0,
+                  (struct sockaddr *)&addr, addrlen, NULL, NULL) != SOCKET_ERROR)
+        return sent;
 
     net_error = WSAGetLastError();
 
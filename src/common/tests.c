@@ -21,7 +21,11 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "common/cmd.h"
 #include "common/common.h"
 #include "common/files.h"
+#include "common/msg.h"
+#include "common/protocol.h"
+#include "common/sizebuf.h"
 #include "common/tests.h"
+#include "common/zone.h"
 #include "refresh/refresh.h"
 #include "system/system.h"
 
@@ -492,6 +496,635 @@ static void Com_TestSnprintf_f(void)
     Com_Printf("%d failures, %d strings tested\n", errors, num_snprintf_tests * 2);
 }
 
+#if USE_CLIENT
+
+// bit by bit reference implementation, MSG_WriteBits/MSG_ReadBits
+// output must stay byte identical to it
+static void ref_write_bits(sizebuf_t *sb, int value, int bits)
+{
+    size_t bitpos = sb->bitpos;
+    int i;
+
+    if (bits < 0) {
+        bits = -bits;
+    }
+
+    for (i = 0; i < bits; i++, bitpos++) {
+        if ((bitpos & 7) == 0) {
+            sb->data[bitpos >> 3] = 0;
+        }
+        sb->data[bitpos >> 3] |= (value & 1) << (bitpos & 7);
+        value >>= 1;
+    }
+
+    sb->bitpos = bitpos;
+    sb->cursize = (bitpos + 7) >> 3;
+}
+
+static int ref_read_bits(sizebuf_t *sb, int bits)
+{
+    size_t bitpos = sb->bitpos;
+    int i, value = 0;
+    bool sgn = false;
+
+    if (bits < 0) {
+        bits = -bits;
+        sgn = true;
+    }
+
+    for (i = 0; i < bits; i++, bitpos++) {
+        unsigned get = (sb->data[bitpos >> 3] >> (bitpos & 7)) & 1;
+        value |= get << i;
+    }
+
+    sb->bitpos = bitpos;
+    sb->readcount = (bitpos + 7) >> 3;
+
+    if (sgn && (value & (1 << (bits - 1)))) {
+        value |= -1 ^ ((1U << bits) - 1);
+    }
+
+    return value;
+}
+
+static uint32_t msgbits_seed;
+
+static uint32_t msgbits_rand(void)
+{
+    msgbits_seed = msgbits_seed * 1664525 + 1013904223;
+    return msgbits_seed >> 8;
+}
+
+static int msgbits_width(uint32_t r)
+{
+    // both signed and unsigned fields of every width
+    int bits = r % 32 + 1;
+
+    if (bits < 32 && (r & 32)) {
+        bits = -bits;
+    }
+    return bits;
+}
+
+// generates a plausible movement stream: small mouse deltas with
+// occasional flicks, sticky movement keys and buttons, 60-125 Hz msec
+static void msgbits_usercmd(usercmd_t *cmd, const usercmd_t *prev)
+{
+    static const short moves[5] = { -400, -200, 0, 200, 400 };
+    uint32_t r = msgbits_rand();
+
+    *cmd = *prev;
+    if (r & 7) {
+        cmd->angles[0] += (int)(msgbits_rand() % 64) - 32;
+        cmd->angles[1] += (int)(msgbits_rand() % 256) - 128;
+    } else {
+        cmd->angles[0] += (int)(msgbits_rand() % 8192) - 4096;
+        cmd->angles[1] += (int)(msgbits_rand() % 16384) - 8192;
+    }
+    if ((r & 0x1f00) == 0) {
+        cmd->angles[2] = msgbits_rand();
+    }
+    if ((r & 0x7000) == 0) {
+        cmd->forwardmove = moves[msgbits_rand() % 5];
+    }
+    if ((r & 0x38000) == 0) {
+        cmd->sidemove = moves[msgbits_rand() % 5];
+    }
+    if ((r & 0x7c0000) == 0) {
+        cmd->upmove = moves[msgbits_rand() % 5] / 2;
+    }
+    if ((r & 0x3800000) == 0) {
+        cmd->buttons = msgbits_rand() & (BUTTON_ATTACK | BUTTON_USE);
+        if (cmd->buttons) {
+            cmd->buttons |= BUTTON_ANY;
+        }
+    }
+    cmd->msec = 8 + msgbits_rand() % 9;
+}
+
+// generates a plausible player state stream: 10 Hz frames of steady
+// movement with view and gun bob, occasional ducks, kicks, flashes and
+// stat changes
+static void msgbits_playerstate(player_state_t *ps)
+{
+    uint32_t r = msgbits_rand();
+    uint32_t r2 = msgbits_rand();
+    int i, v;
+
+    for (i = 0; i < 3; i++) {
+        v = ps->pmove.velocity[i];
+        if (msgbits_rand() & 1) {
+            v += (int)(msgbits_rand() % 512) - 256;
+            clamp(v, -3200, 3200);
+        }
+        ps->pmove.velocity[i] = v;
+        ps->pmove.origin[i] += v / 10;
+    }
+    if ((r & 0x1f) == 0) {
+        ps->pmove.pm_flags ^= PMF_DUCKED;
+    }
+    if ((r & 0x3e0) == 0) {
+        ps->pmove.pm_time = msgbits_rand() % 32;
+    }
+    if ((r & 0xfc00) == 0) {
+        ps->pmove.delta_angles[1] = msgbits_rand();
+    }
+
+    // angles and offsets stay on their wire precision
+    for (i = 0; i < 2; i++) {
+        v = ANGLE2SHORT(ps->viewangles[i]) + (int)(msgbits_rand() % 256) - 128;
+        ps->viewangles[i] = SHORT2ANGLE((short)v);
+    }
+    ps->viewoffset[2] = (88 + (int)(msgbits_rand() % 9) - 4) * 0.25f;
+    ps->kick_angles[0] = (r & 0x3f0000) ? 0 :
+        ((int)(msgbits_rand() % 64) - 32) * 0.25f;
+
+    ps->gunframe = (ps->gunframe + 1) & 63;
+    for (i = 0; i < 3; i++) {
+        ps->gunoffset[i] = ((int)(msgbits_rand() % 8) - 4) * 0.25f;
+    }
+    ps->gunangles[0] = ((int)(msgbits_rand() % 8) - 4) * 0.25f;
+
+    ps->blend[0] = 1;
+    ps->blend[3] = (r2 & 0x1f) ? 0 : (msgbits_rand() % 256) / 255.0f;
+
+    if ((r2 & 0x3e0) == 0) {
+        ps->stats[STAT_HEALTH] -= msgbits_rand() % 20;
+    }
+    if ((r2 & 0xc00) == 0) {
+        ps->stats[STAT_AMMO]--;
+    }
+    if ((r2 & 0xff000) == 0) {
+        ps->stats[STAT_FRAGS]++;
+    }
+}
+
+static bool msgbits_compare_usercmd(const usercmd_t *a, const usercmd_t *b)
+{
+    return a->msec == b->msec && a->buttons == b->buttons &&
+        a->angles[0] == b->angles[0] && a->angles[1] == b->angles[1] &&
+        a->angles[2] == b->angles[2] && a->forwardmove == b->forwardmove &&
+        a->sidemove == b->sidemove && a->upmove == b->upmove;
+}
+
+/*
+=============
+Com_TestMsgBits_f
+
+Checks that MSG_WriteBits/MSG_ReadBits are byte identical to the bit by
+bit reference over a random stream of all field widths and alignments,
+then measures enhanced usercmd and default playerstate delta encoding
+and decoding.
+=============
+*/
+static void Com_TestMsgBits_f(void)
+{
+    sizebuf_t saved_write = msg_write, saved_read = msg_read;
+    sizebuf_t ref;
+    byte *buffer, *refbuf;
+    int *values, *widths;
+    usercmd_t *cmds, cmd;
+    player_state_t *states, ps;
+    player_packed_t *packed, pack;
+    uint64_t start, t_write, t_ref_write, t_read, t_ref_read, t_enc, t_dec;
+    uint64_t t_ps_enc, t_ps_dec;
+    int i, j, n, count, errors, batch;
+    size_t bytes, ps_bytes;
+
+    count = Cmd_Argc() > 1 ? atoi(Cmd_Argv(1)) : 100000;
+    if (count < 1) {
+        Com_Printf("Usage: %s [count]\n", Cmd_Argv(0));
+        return;
+    }
+
+    buffer = Z_Malloc(MAX_MSGLEN);
+    refbuf = Z_Malloc(MAX_MSGLEN);
+    values = Z_Malloc(sizeof(*values) * count);
+    widths = Z_Malloc(sizeof(*widths) * count);
+    cmds = Z_Mallocz(sizeof(*cmds) * (count + 1));
+    packed = Z_Mallocz(sizeof(*packed) * (count + 1));
+    // a message holds at most this many playerstates of 6 bytes minimum
+    states = Z_Mallocz(sizeof(*states) * (MAX_MSGLEN / 6 + 2));
+
+    msgbits_seed = 1;
+    for (i = 0; i < count; i++) {
+        values[i] = msgbits_rand() ^ (msgbits_rand() << 24);
+        widths[i] = msgbits_width(msgbits_rand());
+    }
+    for (i = 1; i <= count; i++) {
+        msgbits_usercmd(&cmds[i], &cmds[i - 1]);
+    }
+
+    memset(&ps, 0, sizeof(ps));
+    ps.pmove.gravity = 800;
+    ps.viewoffset[2] = 22;
+    ps.gunindex = 1;
+    ps.fov = 90;
+    ps.stats[STAT_HEALTH] = 100;
+    ps.stats[STAT_AMMO] = 50;
+    memcpy(&states[0], &ps, sizeof(ps));
+    MSG_PackPlayer(&packed[0], &ps);
+    for (i = 1; i <= count; i++) {
+        msgbits_playerstate(&ps);
+        MSG_PackPlayer(&packed[i], &ps);
+    }
+
+    errors = 0;
+    t_write = t_ref_write = t_read = t_ref_read = t_enc = t_dec = 0;
+    t_ps_enc = t_ps_dec = 0;
+
+    // raw bit fields, in batches that fit a message
+    for (i = 0; i < count; i = j) {
+        SZ_Init(&msg_write, buffer, MAX_MSGLEN);
+        start = Sys_Microseconds();
+        for (j = i; j < count && msg_write.cursize < MAX_MSGLEN - 8; j++) {
+            MSG_WriteBits(values[j], widths[j]);
+        }
+        t_write += Sys_Microseconds() - start;
+        n = j;
+
+        SZ_Init(&ref, refbuf, MAX_MSGLEN);
+        start = Sys_Microseconds();
+        for (j = i; j < n; j++) {
+            ref_write_bits(&ref, values[j], widths[j]);
+        }
+        t_ref_write += Sys_Microseconds() - start;
+
+        if (ref.cursize != msg_write.cursize ||
+            memcmp(ref.data, msg_write.data, ref.cursize)) {
+            Com_EPrintf("MSG_WriteBits output differs in fields %d-%d\n", i, n - 1);
+            errors++;
+        }
+
+        SZ_Init(&msg_read, buffer, msg_write.cursize);
+        msg_read.cursize = msg_write.cursize;
+        start = Sys_Microseconds();
+        for (j = i; j < n; j++) {
+            values[j] = MSG_ReadBits(widths[j]);
+        }
+        t_read += Sys_Microseconds() - start;
+
+        ref.readcount = ref.bitpos = 0;
+        start = Sys_Microseconds();
+        for (j = i; j < n; j++) {
+            values[j] ^= ref_read_bits(&ref, widths[j]);
+        }
+        t_ref_read += Sys_Microseconds() - start;
+
+        for (j = i; j < n; j++) {
+            if (values[j]) {
+                Com_EPrintf("MSG_ReadBits result differs in field %d\n", j);
+                errors++;
+                break;
+            }
+        }
+    }
+
+    // delta compressed usercmd stream
+    bytes = 0;
+    for (i = 1; i <= count; i = j) {
+        SZ_Init(&msg_write, buffer, MAX_MSGLEN);
+        start = Sys_Microseconds();
+        for (j = i; j <= count && msg_write.cursize < MAX_MSGLEN - 32; j++) {
+            MSG_WriteDeltaUsercmd_Enhanced(&cmds[j - 1], &cmds[j],
+                                           PROTOCOL_VERSION_Q2PRO_CURRENT);
+        }
+        t_enc += Sys_Microseconds() - start;
+        n = j;
+        bytes += msg_write.cursize;
+
+        SZ_Init(&msg_read, buffer, msg_write.cursize);
+        msg_read.cursize = msg_write.cursize;
+        batch = 0;
+        start = Sys_Microseconds();
+        for (j = i; j < n; j++) {
+            MSG_ReadDeltaUsercmd_Enhanced(&cmds[j - 1], &cmd,
+                                          PROTOCOL_VERSION_Q2PRO_CURRENT);
+            batch += !msgbits_compare_usercmd(&cmd, &cmds[j]);
+        }
+        t_dec += Sys_Microseconds() - start;
+
+        if (batch) {
+            Com_EPrintf("%d usercmds decoded wrong in %d-%d\n", batch, i, n - 1);
+            errors++;
+        }
+    }
+
+    // delta compressed playerstate stream, decoded states are checked
+    // after timing so that repacking them is not measured
+    ps_bytes = 0;
+    for (i = 1; i <= count; i = j) {
+        SZ_Init(&msg_write, buffer, MAX_MSGLEN);
+        start = Sys_Microseconds();
+        for (j = i; j <= count && msg_write.cursize < MAX_MSGLEN - 256; j++) {
+            MSG_WriteDeltaPlayerstate_Default(&packed[j - 1], &packed[j]);
+        }
+        t_ps_enc += Sys_Microseconds() - start;
+        n = j;
+        ps_bytes += msg_write.cursize;
+
+        SZ_Init(&msg_read, buffer, msg_write.cursize);
+        msg_read.cursize = msg_write.cursize;
+        start = Sys_Microseconds();
+        for (j = i; j < n; j++) {
+            MSG_ParseDeltaPlayerstate_Default(&states[j - i], &states[j - i + 1],
+                                              MSG_ReadWord());
+        }
+        t_ps_dec += Sys_Microseconds() - start;
+
+        batch = 0;
+        for (j = i; j < n; j++) {
+            memset(&pack, 0, sizeof(pack));
+            MSG_PackPlayer(&pack, &states[j - i + 1]);
+            batch += !!memcmp(&pack, &packed[j], sizeof(pack));
+        }
+        memcpy(&states[0], &states[n - i], sizeof(states[0]));
+
+        if (batch) {
+            Com_EPrintf("%d playerstates decoded wrong in %d-%d\n", batch, i, n - 1);
+            errors++;
+        }
+    }
+
+    msg_write = saved_write;
+    msg_read = saved_read;
+
+    Z_Free(buffer);
+    Z_Free(refbuf);
+    Z_Free(values);
+    Z_Free(widths);
+    Z_Free(cmds);
+    Z_Free(packed);
+    Z_Free(states);
+
+    Com_Printf("%d fields: write %.2f msec (reference %.2f), "
+               "read %.2f msec (reference %.2f)\n", count,
+               t_write * 1e-3, t_ref_write * 1e-3,
+               t_read * 1e-3, t_ref_read * 1e-3);
+    Com_Printf("%d usercmds in %"PRIz" bytes: encode %.2f msec, decode %.2f msec\n",
+               count, bytes, t_enc * 1e-3, t_dec * 1e-3);
+    Com_Printf("%d playerstates in %"PRIz" bytes: encode %.2f msec, decode %.2f msec\n",
+               count, ps_bytes, t_ps_enc * 1e-3, t_ps_dec * 1e-3);
+    Com_Printf("%d failures\n", errors);
+}
+
+// mostly byte and word sized values, so that every field width is written
+static uint32_t msgdelta_value(void)
+{
+    uint32_t r = msgbits_rand();
+
+    switch (r & 3) {
+    case 0:
+        return (r >> 2) & 255;
+    case 1:
+        return (r >> 2) & 65535;
+    case 2:
+        return msgbits_rand() ^ (msgbits_rand() << 24);
+    default:
+        return 0;
+    }
+}
+
+// changes about a third of the fields of a packed entity, keeping values
+// in the range the wire format can carry for given flags
+static void msgdelta_change(entity_packed_t *ent, msgEsFlags_t flags)
+{
+    int i;
+
+#define CHANGE  (msgbits_rand() % 3 == 0)
+    for (i = 0; i < 3; i++) {
+        if (CHANGE)
+            ent->origin[i] = msgdelta_value();
+        if (CHANGE) {
+            if (flags & MSG_ES_SHORTANGLES)
+                ent->angles[i] = msgdelta_value();
+            else
+                ent->angles[i] = (msgdelta_value() & 255) << 8;
+        }
+        if (CHANGE)
+            ent->old_origin[i] = msgdelta_value();
+    }
+    if (CHANGE)
+        ent->modelindex = msgdelta_value();
+    if (CHANGE)
+        ent->modelindex2 = msgdelta_value();
+    if (CHANGE)
+        ent->modelindex3 = msgdelta_value();
+    if (CHANGE)
+        ent->modelindex4 = msgdelta_value();
+    if (CHANGE)
+        ent->skinnum = msgdelta_value();
+    if (CHANGE)
+        ent->effects = msgdelta_value();
+    if (CHANGE)
+        ent->renderfx = msgdelta_value();
+    if (CHANGE)
+        ent->solid = msgdelta_value() & ((flags & MSG_ES_LONGSOLID) ? ~0U : 65535);
+    if (CHANGE)
+        ent->frame = msgdelta_value();
+    if (CHANGE)
+        ent->sound = msgdelta_value();
+    ent->event = CHANGE ? msgdelta_value() : 0;
+#undef CHANGE
+}
+
+static void msgdelta_unpack(entity_state_t *out, const entity_packed_t *in)
+{
+    int i;
+
+    memset(out, 0, sizeof(*out));
+    out->number = in->number;
+    for (i = 0; i < 3; i++) {
+        out->origin[i] = in->origin[i] * 0.125f;
+        out->angles[i] = SHORT2ANGLE(in->angles[i]);
+        out->old_origin[i] = in->old_origin[i] * 0.125f;
+    }
+    out->modelindex = in->modelindex;
+    out->modelindex2 = in->modelindex2;
+    out->modelindex3 = in->modelindex3;
+    out->modelindex4 = in->modelindex4;
+    out->skinnum = in->skinnum;
+    out->effects = in->effects;
+    out->renderfx = in->renderfx;
+    out->solid = in->solid;
+    out->frame = in->frame;
+    out->sound = in->sound;
+    out->event = in->event;
+}
+
+// what the receiving side should end up with after parsing the delta,
+// derived from the protocol rules rather than from the encoder
+static void msgdelta_expect(entity_packed_t *out, const entity_packed_t *from,
+                            const entity_packed_t *to, msgEsFlags_t flags)
+{
+    bool oldorigin = false;
+
+    *out = *to;
+
+    if (flags & MSG_ES_FIRSTPERSON) {
+        VectorCopy(from->origin, out->origin);
+        VectorCopy(from->angles, out->angles);
+    } else if (flags & MSG_ES_NEWENTITY) {
+        oldorigin = !VectorCompare(to->old_origin, from->origin);
+    }
+
+    // beams with MSG_ES_BEAMORIGIN only send a changed old_origin, which
+    // ends up the same
+    if (to->renderfx & (RF_FRAMELERP | RF_BEAM))
+        oldorigin = true;
+
+    if (!oldorigin)
+        VectorCopy(from->old_origin, out->old_origin);
+}
+
+/*
+=============
+Com_TestMsgDelta_f
+
+Checks that entity removals and unchanged entities written by
+MSG_WriteDeltaEntity parse back with the right number and bits, then
+round trips random entity pairs under random flags through
+MSG_WriteDeltaEntity and MSG_ParseDeltaEntity.
+=============
+*/
+static void Com_TestMsgDelta_f(void)
+{
+    static const msgEsFlags_t allflags[] = {
+        MSG_ES_FORCE, MSG_ES_NEWENTITY, MSG_ES_FIRSTPERSON, MSG_ES_LONGSOLID,
+        MSG_ES_UMASK, MSG_ES_BEAMORIGIN, MSG_ES_SHORTANGLES, MSG_ES_REMOVE
+    };
+    sizebuf_t saved_write = msg_write, saved_read = msg_read;
+    entity_packed_t ent, *from, *to, expect, result;
+    entity_state_t state, parsed;
+    msgEsFlags_t *flags;
+    byte *buffer;
+    size_t *sizes, start;
+    int i, j, k, n, count, errors, number, bits;
+    int *numbers;
+
+    count = Cmd_Argc() > 1 ? atoi(Cmd_Argv(1)) : 100000;
+    if (count < 1) {
+        Com_Printf("Usage: %s [count]\n", Cmd_Argv(0));
+        return;
+    }
+
+    buffer = Z_Malloc(MAX_MSGLEN);
+    numbers = Z_Malloc(sizeof(*numbers) * count);
+    from = Z_Mallocz(sizeof(*from) * count);
+    to = Z_Mallocz(sizeof(*to) * count);
+    flags = Z_Malloc(sizeof(*flags) * count);
+    sizes = Z_Malloc(sizeof(*sizes) * count);
+
+    msgbits_seed = 1;
+    for (i = 0; i < count; i++) {
+        numbers[i] = 1 + msgbits_rand() % (MAX_EDICTS - 1);
+    }
+
+    memset(&ent, 0, sizeof(ent));
+    errors = 0;
+
+    // removals
+    for (i = 0; i < count; i = j) {
+        SZ_Init(&msg_write, buffer, MAX_MSGLEN);
+        for (j = i; j < count && msg_write.cursize < MAX_MSGLEN - 16; j++) {
+            ent.number = numbers[j];
+            if (j & 1) {
+                // unchanged entity must not be written at all
+                MSG_WriteDeltaEntity(&ent, &ent, 0);
+            }
+            MSG_WriteDeltaEntity(&ent, NULL, 0);
+        }
+        n = j;
+
+        SZ_Init(&msg_read, buffer, msg_write.cursize);
+        msg_read.cursize = msg_write.cursize;
+        for (j = i; j < n; j++) {
+            number = MSG_ParseEntityBits(&bits);
+            if (number != numbers[j] || !(bits & U_REMOVE)) {
+                Com_EPrintf("removal %d parsed as %d (bits %#x), expected %d\n",
+                            j, number, bits, numbers[j]);
+                errors++;
+                break;
+            }
+        }
+        if (j == n && msg_read.readcount != msg_read.cursize) {
+            Com_EPrintf("%"PRIz" stray bytes after removals %d-%d\n",
+                        msg_read.cursize - msg_read.readcount, i, n - 1);
+            errors++;
+        }
+    }
+
+    // random deltas
+    for (i = 0; i < count; i++) {
+        flags[i] = 0;
+        for (k = 0; k < q_countof(allflags); k++) {
+            if (msgbits_rand() % 3 == 0) {
+                flags[i] |= allflags[k];
+            }
+        }
+        from[i].number = to[i].number = numbers[i];
+        msgdelta_change(&from[i], flags[i]);
+        from[i].event = 0;
+        to[i] = from[i];
+        msgdelta_change(&to[i], flags[i]);
+    }
+
+    for (i = 0; i < count; i = j) {
+        SZ_Init(&msg_write, buffer, MAX_MSGLEN);
+        for (j = i; j < count && msg_write.cursize < MAX_MSGLEN - 64; j++) {
+            start = msg_write.cursize;
+            MSG_WriteDeltaEntity(&from[j], &to[j], flags[j]);
+            sizes[j] = msg_write.cursize - start;
+        }
+        n = j;
+
+        SZ_Init(&msg_read, buffer, msg_write.cursize);
+        msg_read.cursize = msg_write.cursize;
+        for (j = i; j < n; j++) {
+            msgdelta_expect(&expect, &from[j], &to[j], flags[j]);
+            if (!sizes[j]) {
+                // nothing written means nothing changed for the receiver
+                result = from[j];
+            } else {
+                number = MSG_ParseEntityBits(&bits);
+                if (number != numbers[j]) {
+                    Com_EPrintf("delta %d parsed as entity %d, expected %d\n",
+                                j, number, numbers[j]);
+                    errors++;
+                    break;
+                }
+                msgdelta_unpack(&state, &from[j]);
+                MSG_ParseDeltaEntity(&state, &parsed, number, bits, flags[j]);
+                MSG_PackEntity(&result, &parsed, flags[j] & MSG_ES_SHORTANGLES);
+            }
+            if (memcmp(&result, &expect, sizeof(result))) {
+                Com_EPrintf("delta %d (flags %#x) parsed back wrong\n", j, flags[j]);
+                errors++;
+                break;
+            }
+        }
+        if (j == n && msg_read.readcount != msg_read.cursize) {
+            Com_EPrintf("%"PRIz" stray bytes after deltas %d-%d\n",
+                        msg_read.cursize - msg_read.readcount, i, n - 1);
+            errors++;
+        }
+    }
+
+    msg_write = saved_write;
+    msg_read = saved_read;
+
+    Z_Free(buffer);
+    Z_Free(numbers);
+    Z_Free(from);
+    Z_Free(to);
+    Z_Free(flags);
+    Z_Free(sizes);
+
+    Com_Printf("%d failures, %d removals and %d deltas tested\n", errors, count, count);
+}
+
+#endif // USE_CLIENT
+
 #if USE_REF
 static void Com_TestModels_f(void)
 {
@@ -536,6 +1169,10 @@ void TST_Init(void)
     Cmd_AddCommand("normtest", Com_TestNorm_f);
     Cmd_AddCommand("infotest", Com_TestInfo_f);
     Cmd_AddCommand("snprintftest", Com_TestSnprintf_f);
+#if USE_CLIENT
+    Cmd_AddCommand("msgbitstest", Com_TestMsgBits_f);
+    Cmd_AddCommand("msgdeltatest", Com_TestMsgDelta_f);
+#endif
 #if USE_REF
     Cmd_AddCommand("modeltest", Com_TestModels_f);
 #endif
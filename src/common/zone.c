@@ -49,6 +49,7 @@ typedef struct {
 static zhead_t      z_chain;
 static zstatic_t    z_static[11];
 static zstats_t     z_stats[TAG_MAX];
+static size_t       z_allocs;
 
 static const char   z_tagnames[TAG_MAX][8] = {
     "game",
@@ -77,6 +78,7 @@ static inline void Z_CountAlloc(zhead_t *z)
     zstats_t *s = &z_stats[z->tag < TAG_MAX ? z->tag : TAG_FREE];
     s->count++;
     s->bytes += z->size;
+    z_allocs++;
 }
 
 static inline void Z_Validate(zhead_t *z, const char *func)
@@ -218,6 +220,18 @@ void Z_Stats_f(void)
                bytes, count);
 }
 
+/*
+========================
+Z_AllocCount
+
+Returns the number of allocations made since startup.
+========================
+*/
+size_t Z_AllocCount(void)
+{
+    return z_allocs;
+}
+
 /*
 ========================
 Z_FreeTags
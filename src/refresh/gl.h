@@ -22,6 +22,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "common/common.h"
 #include "common/cvar.h"
 #include "common/files.h"
+#include "common/loadprof.h"
 #include "common/math.h"
 #include "client/video.h"
 #include "client/client.h"
@@ -25,6 +25,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "common/common.h"
 #include "common/cvar.h"
 #include "common/files.h"
+#include "common/loadprof.h"
 #include "system/system.h"
 #include "format/pcx.h"
 #include "format/wal.h"
@@ -1468,13 +1469,17 @@ static int _try_image_format(imageformat_t fmt, image_t *image, byte **pic)
     int     len, ret;
 
     // load the file
+    LoadProf_Begin("IMG file", image->name);
     len = FS_LoadFile(image->name, (void **)&data);
+    LoadProf_End();
     if (!data) {
         return len;
     }
 
     // decompress the image
+    LoadProf_Begin("IMG decode", image->name);
     ret = img_loaders[fmt].load(data, len, image, pic);
+    LoadProf_End();
 
     FS_FreeFile(data);
 
@@ -1697,7 +1702,9 @@ static int find_or_load_image(const char *name, size_t len,
     List_Append(&r_imageHash[hash], &image->entry);
 
     // upload the image
+    LoadProf_Begin("IMG upload", image->name);
     IMG_Load(image, pic);
+    LoadProf_End();
 
     *image_p = image;
     return Q_ERR_SUCCESS;
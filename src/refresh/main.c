@@ -912,7 +912,9 @@ void R_BeginRegistration(const char *name)
     glr.viewcluster1 = glr.viewcluster2 = -2;
 
     Q_concat(fullname, sizeof(fullname), "maps/", name, ".bsp", NULL);
+    LoadProf_Begin("GL_LoadWorld", fullname);
     GL_LoadWorld(fullname);
+    LoadProf_End();
 }
 
 /*
@@ -730,7 +730,9 @@ qhandle_t R_RegisterModel(const char *name)
         goto done;
     }
 
+    LoadProf_Begin("MOD file", normalized);
     filelen = FS_LoadFile(normalized, (void **)&rawdata);
+    LoadProf_End();
     if (!rawdata) {
         // don't spam about missing models
         if (filelen == Q_ERR_NOENT) {
@@ -774,7 +776,9 @@ qhandle_t R_RegisterModel(const char *name)
     memcpy(model->name, normalized, namelen + 1);
     model->registration_sequence = registration_sequence;
 
+    LoadProf_Begin("MOD decode", normalized);
     ret = load(model, rawdata, filelen);
+    LoadProf_End();
 
     FS_FreeFile(rawdata);
 
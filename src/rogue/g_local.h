@@ -648,6 +648,7 @@ extern	cvar_t	*flood_persecond;
 extern	cvar_t	*flood_waitdelay;
 
 extern	cvar_t	*sv_maplist;
+extern	cvar_t	*g_seed;
 
 extern	cvar_t	*sv_stopspeed;		// PGM - this was a define in g_phys.c
 
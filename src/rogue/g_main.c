@@ -51,6 +51,7 @@ cvar_t	*flood_persecond;
 cvar_t	*flood_waitdelay;
 
 cvar_t	*sv_maplist;
+cvar_t	*g_seed;
 
 cvar_t	*sv_stopspeed;	//PGM	 (this was a define in g_phys.c)
 
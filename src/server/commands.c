@@ -611,16 +611,26 @@ static void dump_time(void)
 static void dump_lag(void)
 {
     client_t    *cl;
+    int         fps;
 
     Com_Printf(
-        "num name            PLs2c PLc2s Rmin Ravg Rmax dup\n"
-        "--- --------------- ----- ----- ---- ---- ---- ---\n");
+        "num name            PLs2c PLc2s Rmin Ravg Rmax dup fps budget\n"
+        "--- --------------- ----- ----- ---- ---- ---- --- --- ------\n");
 
     FOR_EACH_CLIENT(cl) {
-        Com_Printf("%3i %-15.15s %5.2f %5.2f %4d %4d %4d %3d\n",
+#if USE_FPS
+        fps = sv.framerate / cl->framediv;
+#else
+        fps = BASE_FRAMERATE;
+#endif
+        Com_Printf("%3i %-15.15s %5.2f %5.2f %4d %4d %4d %3d %3d ",
                    cl->number, cl->name, PL_S2C(cl), PL_C2S(cl),
                    cl->min_ping, AVG_PING(cl), cl->max_ping,
-                   cl->numpackets - 1);
+                   cl->numpackets - 1, fps);
+        if (cl->adapt_budget)
+            Com_Printf("%6"PRIz"\n", cl->adapt_budget);
+        else
+            Com_Printf("   -\n");
     }
 }
 
@@ -774,6 +784,10 @@ void SV_PrintMiscInfo(void)
                sv_client->protocol, sv_client->version);
     Com_Printf("maxmsglen            %"PRIz"\n", sv_client->netchan->maxpacketlen);
     Com_Printf("zlib support         %s\n", sv_client->has_zlib ? "yes" : "no");
+#if USE_ZLIB
+    if (sv_client->has_zlib)
+        Com_Printf("compression codec    %s\n", SV_CodecName(sv_client->codec));
+#endif
     Com_Printf("netchan type         %s\n", sv_client->netchan->type ? "new" : "old");
     Com_Printf("ping                 %d\n", sv_client->ping);
     Com_Printf("movement fps         %d\n", sv_client->moves_per_sec);
@@ -787,6 +801,10 @@ void SV_PrintMiscInfo(void)
 #ifdef USE_PACKETDUP
     Com_Printf("packetdup            %d\n", sv_client->numpackets - 1);
 #endif
+    Com_Printf("deferred entities    %u in %u frames\n",
+               sv_client->entities_deferred, sv_client->frames_deferred);
+    if (sv_client->adapt_budget)
+        Com_Printf("adaptive budget      %"PRIz" bytes\n", sv_client->adapt_budget);
     Com_TimeDiff(buffer, sizeof(buffer),
                  &sv_client->connect_time, time(NULL));
     Com_Printf("connection time      %s\n", buffer);
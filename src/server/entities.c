@@ -30,6 +30,202 @@ Encode a client frame onto the network channel
 #define Q2PRO_OPTIMIZE(c) \
     ((c)->protocol == PROTOCOL_VERSION_Q2PRO && !(c)->settings[CLS_RECORDING])
 
+#define DELTA_MEMO_BYTES    64      // largest delta is a bit less than that
+
+typedef struct {
+    int             framenum;
+    msgEsFlags_t    flags;
+    unsigned        len;
+    entity_packed_t from, to;
+    byte            data[DELTA_MEMO_BYTES];
+} deltaMemo_t;
+
+static deltaMemo_t  delta_memo[MAX_EDICTS];
+
+/*
+=============
+SV_WriteDeltaEntity
+
+Most clients delta the same entities from the same server frame. Remember
+the last delta encoded for each entity number during this server frame and
+copy it out for other clients with identical flags and states. States are
+compared because packed entities may differ between clients (own missiles
+aren't solid, deferred updates patch the old frame).
+=============
+*/
+static void SV_WriteDeltaEntity(const entity_packed_t *from,
+                                const entity_packed_t *to,
+                                msgEsFlags_t flags)
+{
+    deltaMemo_t *m = &delta_memo[to->number];
+    size_t start, len;
+
+    if (m->framenum == sv.framenum && m->flags == flags &&
+        !memcmp(&m->to, to, sizeof(*to)) &&
+        !memcmp(&m->from, from, sizeof(*from))) {
+        MSG_WriteData(m->data, m->len);
+        return;
+    }
+
+    start = msg_write.cursize;
+    MSG_WriteDeltaEntity(from, to, flags);
+
+    len = msg_write.cursize - start;
+    if (msg_write.overflowed || len > sizeof(m->data)) {
+        m->framenum = -1;
+        return;
+    }
+
+    m->framenum = sv.framenum;
+    m->flags = flags;
+    m->len = len;
+    m->from = *from;
+    m->to = *to;
+    memcpy(m->data, msg_write.data + start, len);
+}
+
+/*
+=============================================================================
+
+Entity budgeting
+
+When a frame doesn't fit into client->frame_budget, entity updates that
+aren't required are deferred to later frames, least important first.
+The frame being built is patched to hold the state the client actually
+gets, so later deltas (and acknowledgements) stay consistent.
+
+=============================================================================
+*/
+
+typedef struct {
+    unsigned                start, len;     // encoded delta in msg_write
+    unsigned                newindex;       // index in the new frame
+    int                     number;
+    unsigned                score;          // lower is more important
+    const entity_packed_t   *oldent;        // what client has, NULL if new
+    bool                    deferred;
+} entityUpdate_t;
+
+static entityUpdate_t   entity_updates[MAX_PACKET_ENTITIES];
+static int              num_entity_updates;
+
+static void add_entity_update(client_t *client, client_frame_t *frame,
+                              unsigned start, unsigned newindex,
+                              const entity_packed_t *oldent,
+                              const entity_packed_t *newent)
+{
+    entityUpdate_t *u;
+    unsigned dist;
+    int i, stale;
+
+    if (msg_write.cursize == start)
+        return;     // nothing was written
+
+    if (num_entity_updates == MAX_PACKET_ENTITIES)
+        return;
+
+    // distance from the viewer, in packed 1/8 units
+    dist = 0;
+    for (i = 0; i < 3; i++)
+        dist += abs(newent->origin[i] - frame->ps.pmove.origin[i]);
+
+    // other players are more relevant than the rest
+    if (newent->number <= client->maxclients)
+        dist >>= 1;
+
+    // each deferred frame halves the distance
+    stale = client->entity_deferred[newent->number];
+
+    u = &entity_updates[num_entity_updates++];
+    u->start = start;
+    u->len = msg_write.cursize - start;
+    u->newindex = newindex;
+    u->number = newent->number;
+    u->score = dist >> min(stale, 16);
+    u->oldent = oldent;
+    u->deferred = false;
+}
+
+static int entityupdatecmp(const void *p1, const void *p2)
+{
+    const entityUpdate_t *u1 = *(const entityUpdate_t **)p1;
+    const entityUpdate_t *u2 = *(const entityUpdate_t **)p2;
+
+    if (u1->score != u2->score)
+        return u1->score > u2->score ? -1 : 1;
+    return u1->number - u2->number;
+}
+
+static void defer_entity_updates(client_t *client, client_frame_t *frame,
+                                 size_t excess)
+{
+    entityUpdate_t *sorted[MAX_PACKET_ENTITIES], *u;
+    entity_packed_t *ent;
+    unsigned i, j, num_entities;
+    size_t dropped, src, dst;
+    int count;
+
+    for (i = 0; i < num_entity_updates; i++)
+        sorted[i] = &entity_updates[i];
+
+    // least important first
+    qsort(sorted, num_entity_updates, sizeof(sorted[0]), entityupdatecmp);
+
+    dropped = 0;
+    count = 0;
+    for (i = 0; i < num_entity_updates && dropped < excess; i++) {
+        sorted[i]->deferred = true;
+        dropped += sorted[i]->len;
+        count++;
+    }
+
+    // squeeze deferred deltas out of the message, updates are in order
+    dst = src = entity_updates[0].start;
+    for (i = 0; i < num_entity_updates; i++) {
+        u = &entity_updates[i];
+        if (!u->deferred)
+            continue;
+        memmove(msg_write.data + dst, msg_write.data + src, u->start - src);
+        dst += u->start - src;
+        src = u->start + u->len;
+    }
+    memmove(msg_write.data + dst, msg_write.data + src, msg_write.cursize - src);
+    msg_write.cursize -= dropped;
+    msg_write.bitpos = msg_write.cursize << 3;
+
+    // client keeps the old state of deferred entities, and doesn't know
+    // about deferred new ones at all
+    num_entities = 0;
+    for (i = j = 0; i < frame->num_entities; i++) {
+        ent = &svs.entities[(frame->first_entity + i) % svs.num_entities];
+        while (j < num_entity_updates && entity_updates[j].newindex < i)
+            j++;
+        u = j < num_entity_updates && entity_updates[j].newindex == i ?
+            &entity_updates[j] : NULL;
+        if (u && u->deferred) {
+            if (!u->oldent)
+                continue;
+            *ent = *u->oldent;
+        }
+        if (num_entities != i)
+            svs.entities[(frame->first_entity + num_entities) % svs.num_entities] = *ent;
+        num_entities++;
+    }
+    frame->num_entities = num_entities;
+
+    for (i = 0; i < num_entity_updates; i++) {
+        u = &entity_updates[i];
+        if (u->deferred && client->entity_deferred[u->number] < 255)
+            client->entity_deferred[u->number]++;
+    }
+
+    client->frames_deferred++;
+    client->entities_deferred += count;
+
+    SV_DPrintf(0, "Frame %d for %s: deferred %d entities, %"PRIz" bytes\n",
+               client->framenum, client->name, count, dropped);
+}
+
 /*
 =============
 SV_EmitPacketEntities
@@ -44,7 +240,7 @@ static void SV_EmitPacketEntities(client_t         *client,
 {
     entity_packed_t *newent;
     const entity_packed_t *oldent;
-    unsigned i, oldindex, newindex, from_num_entities;
+    unsigned i, oldindex, newindex, from_num_entities, start;
     int oldnum, newnum;
     msgEsFlags_t flags;
 
@@ -56,6 +252,7 @@ static void SV_EmitPacketEntities(client_t         *client,
     newindex = 0;
     oldindex = 0;
     oldent = newent = NULL;
+    num_entity_updates = 0;
     while (newindex < to->num_entities || oldindex < from_num_entities) {
         if (newindex >= to->num_entities) {
             newnum = 9999;
@@ -91,7 +288,11 @@ static void SV_EmitPacketEntities(client_t         *client,
             if (Q2PRO_SHORTANGLES(client, newnum)) {
                 flags |= MSG_ES_SHORTANGLES;
             }
-            MSG_WriteDeltaEntity(oldent, newent, flags);
+            start = msg_write.cursize;
+            SV_WriteDeltaEntity(oldent, newent, flags);
+            if (newnum != clientEntityNum && !newent->event) {
+                add_entity_update(client, to, start, newindex, oldent, newent);
+            }
             oldindex++;
             newindex++;
             continue;
@@ -114,7 +315,11 @@ static void SV_EmitPacketEntities(client_t         *client,
             if (Q2PRO_SHORTANGLES(client, newnum)) {
                 flags |= MSG_ES_SHORTANGLES;
             }
-            MSG_WriteDeltaEntity(oldent, newent, flags);
+            start = msg_write.cursize;
+            SV_WriteDeltaEntity(oldent, newent, flags);
+            if (newnum != clientEntityNum && !newent->event) {
+                add_entity_update(client, to, start, newindex, NULL, newent);
+            }
             newindex++;
             continue;
         }
@@ -127,6 +332,18 @@ static void SV_EmitPacketEntities(client_t         *client,
         }
     }
 
+    // defer least important updates if frame doesn't fit
+    if (client->frame_budget && num_entity_updates &&
+        msg_write.cursize + 2 > client->frame_budget) {
+        defer_entity_updates(client, to, msg_write.cursize + 2 - client->frame_budget);
+    }
+
+    for (i = 0; i < num_entity_updates; i++) {
+        if (!entity_updates[i].deferred) {
+            client->entity_deferred[entity_updates[i].number] = 0;
+        }
+    }
+
     MSG_WriteShort(0);      // end of packetentities
 }
 
@@ -18,6 +18,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 // sv_game.c -- interface to the game dll
 
 #include "server.h"
+#include "speedrun/splits.h"
 #include "speedrun/timer.h"
 
 game_export_t    *ge;
@@ -398,6 +399,8 @@ static void PF_configstring(int index, const char *val)
     memcpy(dst, val, len);
     dst[len] = 0;
 
+    SV_FlushGamestateCache();
+
     if (sv.state == ss_loading) {
         return;
     }
@@ -425,10 +428,18 @@ static void PF_WriteFloat(float f)
     Com_Error(ERR_DROP, "PF_WriteFloat not implemented");
 }
 
+/*
+=================
+PF_inVIS
+
+Game code tends to test many points against the same origin in a row,
+so the last decompressed row is kept for each vis type and reused while
+p1 stays in the same cluster.
+=================
+*/
 static qboolean PF_inVIS(vec3_t p1, vec3_t p2, int vis)
 {
     mleaf_t *leaf1, *leaf2;
-    byte mask[VIS_MAX_BYTES];
     bsp_t *bsp = sv.cm.cache;
 
     if (!bsp) {
@@ -436,12 +447,16 @@ static qboolean PF_inVIS(vec3_t p1, vec3_t p2, int vis)
     }
 
     leaf1 = BSP_PointLeaf(bsp->nodes, p1);
-    BSP_ClusterVis(bsp, mask, leaf1->cluster, vis);
+    if (sv.viscache[vis].bsp != bsp || sv.viscache[vis].cluster != leaf1->cluster) {
+        BSP_ClusterVis(bsp, sv.viscache[vis].mask, leaf1->cluster, vis);
+        sv.viscache[vis].bsp = bsp;
+        sv.viscache[vis].cluster = leaf1->cluster;
+    }
 
     leaf2 = BSP_PointLeaf(bsp->nodes, p2);
     if (leaf2->cluster == -1)
         return false;
-    if (!Q_IsBitSet(mask, leaf2->cluster))
+    if (!Q_IsBitSet(sv.viscache[vis].mask, leaf2->cluster))
         return false;
     if (!CM_AreasConnected(&sv.cm, leaf1->area, leaf2->area))
         return false;       // a door blocks it
@@ -926,6 +941,9 @@ void SV_InitGameProgs(void)
     import.SpeedrunLevelFinished = SpeedrunLevelFinished;
     import.SpeedrunGetTotalTimeString = SpeedrunGetTotalTimeString;
     import.SpeedrunGetLevelTimeString = SpeedrunGetLevelTimeString;
+    import.SpeedrunRunFinished = SpeedrunSplitsRunFinished;
+
+    import.Microseconds = Sys_Microseconds;
 
     ge = entry(&import);
     if (!ge) {
@@ -17,6 +17,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 */
 
 #include "server.h"
+#include "speedrun/splits.h"
 
 server_static_t svs;                // persistant server info
 server_t        sv;                 // local server
@@ -32,6 +33,7 @@ void SV_ClientReset(client_t *client)
     client->framenum = 1; // frame 0 can't be used
     client->lastframe = -1;
     client->frames_nodelta = 0;
+    memset(client->entity_deferred, 0, sizeof(client->entity_deferred));
     client->send_delta = 0;
     client->suppress_count = 0;
     memset(&client->lastcmd, 0, sizeof(client->lastcmd));
@@ -143,6 +145,8 @@ void SV_SpawnServer(mapcmd_t *cmd)
     char        *entitystring;
 
     SpeedrunUnpauseTimer();
+    SpeedrunBeginLoad(SPEEDRUN_LOAD_MAP);
+    LoadProf_Begin("SV_SpawnServer", cmd->server);
 
     SCR_BeginLoadingPlaque();           // for local system
 
@@ -192,6 +196,7 @@ void SV_SpawnServer(mapcmd_t *cmd)
 
     if (cmd->state == ss_game) {
         override_entity_string(cmd->server);
+        SpeedrunSplitsStartLevel(cmd->server);
 
         sv.cm = cmd->cm;
         sprintf(sv.configstrings[CS_MAPCHECKSUM], "%d", (int)sv.cm.cache->checksum);
@@ -222,18 +227,31 @@ void SV_SpawnServer(mapcmd_t *cmd)
     // map initialization
     sv.state = ss_loading;
 
+    // start pending user command recording
+    SV_ReplayMapSpawn(cmd);
+
     // load and spawn all other entities
+    SpeedrunBeginLoad(SPEEDRUN_LOAD_PRECACHE);
+    LoadProf_Begin("SpawnEntities", NULL);
     ge->SpawnEntities(sv.name, entitystring, cmd->spawnpoint);
+    LoadProf_End();
 
     // run two frames to allow everything to settle
+    LoadProf_Begin("RunFrame", NULL);
     ge->RunFrame(false); sv.framenum++;
     ge->RunFrame(false); sv.framenum++;
+    LoadProf_End();
+    SpeedrunEndLoad(SPEEDRUN_LOAD_PRECACHE);
+
+    SV_ReplayMapSpawned();
 
     // make sure maxclients string is correct
     sprintf(sv.configstrings[CS_MAXCLIENTS], "%d", sv_maxclients->integer);
 
     // check for a savegame
+    LoadProf_Begin("SV_CheckForSavegame", NULL);
     SV_CheckForSavegame(cmd);
+    LoadProf_End();
 
     // all precaches are complete
     sv.state = cmd->state;
@@ -257,7 +275,14 @@ void SV_SpawnServer(mapcmd_t *cmd)
 
     SV_BroadcastCommand("reconnect\n");
 
+    SpeedrunEndLoad(SPEEDRUN_LOAD_MAP);
+    LoadProf_End();
+
     Com_Printf("-------------------------------------\n");
+
+    // local clients finish the profile once they have precached
+    if (dedicated->integer)
+        LoadProf_EndLevel();
 }
 
 /*
@@ -321,13 +346,19 @@ bool SV_ParseMapCmd(mapcmd_t *cmd)
         if (len >= sizeof(expanded)) {
             ret = Q_ERR_NAMETOOLONG;
         } else {
+            LoadProf_BeginLevel(s);
+            LoadProf_Begin("CM_LoadMap", expanded);
+            SpeedrunBeginLoad(SPEEDRUN_LOAD_MAP);
             ret = CM_LoadMap(&cmd->cm, expanded);
+            SpeedrunEndLoad(SPEEDRUN_LOAD_MAP);
+            LoadProf_End();
         }
         cmd->state = ss_game;
     }
 
     if (ret < 0) {
         Com_Printf("Couldn't load %s: %s\n", expanded, Q_ErrorString(ret));
+        LoadProf_Abort();
         return false;
     }
 
@@ -385,7 +416,7 @@ void SV_InitGame(unsigned mvd_spawn)
 
         // dedicated servers can't be single player and are usually DM
         // so unless they explicity set coop, force it to deathmatch
-        if (COM_DEDICATED) {
+        if (COM_DEDICATED && !SV_ReplayActive()) {
             if (!Cvar_VariableInteger("coop"))
                 Cvar_Set("deathmatch", "1");
         }
@@ -423,10 +454,8 @@ void SV_InitGame(unsigned mvd_spawn)
     Cvar_ClampInteger(sv_reserved_slots, 0, sv_maxclients->integer - 1);
 
 #if USE_ZLIB
-    svs.z.zalloc = SV_zalloc;
-    svs.z.zfree = SV_zfree;
-    if (deflateInit2(&svs.z, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
-                     -MAX_WBITS, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+    svs.z_codec = SV_CODEC_DEFLATE;
+    if (SV_DeflateInit(&svs.z, svs.z_codec, -MAX_WBITS, 9) != Z_OK) {
         Com_Error(ERR_FATAL, "%s: deflateInit2() failed", __func__);
     }
 #endif
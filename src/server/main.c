@@ -77,6 +77,10 @@ cvar_t  *sv_waterjump_hack;
 #if USE_PACKETDUP
 cvar_t  *sv_packetdup_hack;
 #endif
+#if USE_ZLIB
+cvar_t  *sv_compress;
+#endif
+cvar_t  *sv_adaptive_rate;
 cvar_t  *sv_allow_map;
 #if !USE_CLIENT
 cvar_t  *sv_recycle;
@@ -225,6 +229,8 @@ void SV_DropClient(client_t *client, const char *reason)
     MSG_WriteByte(svc_disconnect);
     SV_ClientAddMessage(client, MSG_RELIABLE | MSG_CLEAR);
 
+    SV_ReplayDisconnect(client);
+
     if (oldstate == cs_spawned || (g_features->integer & GMF_WANT_ALL_DISCONNECTS)) {
         // call the prog function for removing a client
         // this will remove the body, among other things
@@ -1088,6 +1094,9 @@ static void SVC_DirectConnect(void)
     newcl->protocol = params.protocol;
     newcl->version = params.version;
     newcl->has_zlib = params.has_zlib;
+#if USE_ZLIB
+    newcl->codec = SV_CodecForName(sv_compress->string);
+#endif
     newcl->edict = EDICT_NUM(number + 1);
     newcl->gamedir = fs_game->string;
     newcl->mapname = sv.name;
@@ -1100,6 +1109,7 @@ static void SVC_DirectConnect(void)
     strcpy(newcl->reconnect_val, params.reconnect_val);
 #if USE_FPS
     newcl->framediv = sv.framediv;
+    newcl->requested_framediv = sv.framediv;
     newcl->settings[CLS_FPS] = BASE_FRAMERATE;
 #endif
 
@@ -1107,6 +1117,8 @@ static void SVC_DirectConnect(void)
 
     append_extra_userinfo(&params, userinfo);
 
+    SV_ReplayConnect(newcl, userinfo);
+
     // get the game a chance to reject this connection or modify the userinfo
     sv_client = newcl;
     sv_player = newcl->edict;
@@ -1708,6 +1720,8 @@ static void SV_RunGameFrame(void)
 
     ge->RunFrame(true);
 
+    SV_ReplayFrame();
+
 #if USE_CLIENT
     if (host_speeds->integer)
         time_after_game = Sys_Milliseconds();
@@ -1841,9 +1855,12 @@ unsigned SV_Frame(unsigned msec)
         SV_SendAsyncPackets();
     }
 
-    // move autonomous things around if enough time has passed
+    // move autonomous things around if enough time has passed,
+    // timedemo replays run frames back to back
     sv.frameresidual += msec;
-    if (sv.frameresidual < SV_FRAMETIME) {
+    if (SV_ReplayTimedemo()) {
+        sv.frameresidual = SV_FRAMETIME;
+    } else if (sv.frameresidual < SV_FRAMETIME) {
         return SV_FRAMETIME - sv.frameresidual;
     }
 
@@ -1857,20 +1874,24 @@ unsigned SV_Frame(unsigned msec)
         // give the clients some timeslices
         SV_GiveMsec();
 
-        // let everything in the world think and move
-        SV_RunGameFrame();
+        // feed input of timedemo replay clients, nothing is left to run
+        // if the replay has just ended
+        if (SV_ReplayRunClients()) {
+            // let everything in the world think and move
+            SV_RunGameFrame();
 
-        // send messages back to the UDP clients
-        SV_SendClientMessages();
+            // send messages back to the UDP clients
+            SV_SendClientMessages();
 
-        // send a heartbeat to the master if needed
-        SV_MasterHeartbeat();
+            // send a heartbeat to the master if needed
+            SV_MasterHeartbeat();
 
-        // clear teleport flags, etc for next frame
-        SV_PrepWorldFrame();
+            // clear teleport flags, etc for next frame
+            SV_PrepWorldFrame();
 
-        // advance for next frame
-        sv.framenum++;
+            // advance for next frame
+            sv.framenum++;
+        }
     }
 
     if (COM_DEDICATED) {
@@ -1882,7 +1903,7 @@ unsigned SV_Frame(unsigned msec)
 
     // decide how long to sleep next frame
     sv.frameresidual -= SV_FRAMETIME;
-    if (sv.frameresidual < SV_FRAMETIME) {
+    if (sv.frameresidual < SV_FRAMETIME && !SV_ReplayTimedemo()) {
         return SV_FRAMETIME - sv.frameresidual;
     }
 
@@ -1912,6 +1933,8 @@ void SV_UserinfoChanged(client_t *cl)
     size_t  len;
     int     i;
 
+    SV_ReplayUserinfo(cl);
+
     // call prog code to allow overrides
     ge->ClientUserinfoChanged(cl->edict, cl->userinfo);
 
@@ -2048,6 +2071,76 @@ void SV_zfree(voidpf opaque, voidpf address)
 {
     Z_Free(address);
 }
+
+static const struct {
+    const char  *name;
+    int         level;
+    int         strategy;
+} sv_codecs[SV_CODEC_MAX] = {
+    { "deflate", Z_DEFAULT_COMPRESSION, Z_DEFAULT_STRATEGY },
+    { "fast",    Z_BEST_SPEED,          Z_DEFAULT_STRATEGY },
+    { "huffman", Z_BEST_SPEED,          Z_HUFFMAN_ONLY }
+};
+
+sv_codec_t SV_CodecForName(const char *name)
+{
+    int i;
+
+    for (i = 0; i < SV_CODEC_MAX; i++) {
+        if (!Q_stricmp(name, sv_codecs[i].name)) {
+            return i;
+        }
+    }
+
+    return SV_CODEC_DEFLATE;
+}
+
+const char *SV_CodecName(sv_codec_t codec)
+{
+    return sv_codecs[codec].name;
+}
+
+int SV_DeflateInit(z_streamp z, sv_codec_t codec, int windowBits, int memLevel)
+{
+    z->zalloc = SV_zalloc;
+    z->zfree = SV_zfree;
+    return deflateInit2(z, sv_codecs[codec].level, Z_DEFLATED,
+                        windowBits, memLevel, sv_codecs[codec].strategy);
+}
+
+/*
+===============
+SV_DeflateReset
+
+Prepares shared svs.z stream for compressing a new message with
+the given codec. Parameters are only changed on a freshly reset
+stream, which makes deflateParams() cheap and never flushes. If it
+fails, the codec is left unchanged and retried next time.
+===============
+*/
+void SV_DeflateReset(sv_codec_t codec)
+{
+    deflateReset(&svs.z);
+    if (svs.z_codec != codec &&
+        deflateParams(&svs.z, sv_codecs[codec].level,
+                      sv_codecs[codec].strategy) == Z_OK) {
+        svs.z_codec = codec;
+    }
+}
+
+void sv_codec_changed(cvar_t *self)
+{
+    int i;
+
+    for (i = 0; i < SV_CODEC_MAX; i++) {
+        if (!Q_stricmp(self->string, sv_codecs[i].name)) {
+            return;
+        }
+    }
+
+    Com_WPrintf("Unknown %s codec \"%s\", using %s.\n",
+                self->name, self->string, sv_codecs[SV_CODEC_DEFLATE].name);
+}
 #endif
 
 /*
@@ -2063,6 +2156,8 @@ void SV_Init(void)
 
     SV_MvdRegister();
 
+    SV_ReplayRegister();
+
 #if USE_MVD_CLIENT
     MVD_Register();
 #endif
@@ -2133,6 +2228,13 @@ void SV_Init(void)
     sv_packetdup_hack = Cvar_Get("sv_packetdup_hack", "0", 0);
 #endif
 
+#if USE_ZLIB
+    sv_compress = Cvar_Get("sv_compress", "deflate", 0);
+    sv_compress->changed = sv_codec_changed;
+#endif
+
+    sv_adaptive_rate = Cvar_Get("sv_adaptive_rate", "0", 0);
+
     sv_allow_map = Cvar_Get("sv_allow_map", "0", 0);
 
 #if !USE_CLIENT
@@ -2269,6 +2371,8 @@ void SV_Shutdown(const char *finalmsg, error_type_t type)
 
     SV_MvdShutdown(type);
 
+    SV_ReplayShutdown();
+
     SV_FinalMessage(finalmsg, type);
     SV_MasterShutdown();
     SV_ShutdownGameProgs();
@@ -2284,6 +2388,7 @@ void SV_Shutdown(const char *finalmsg, error_type_t type)
 #if USE_ZLIB
     deflateEnd(&svs.z);
 #endif
+    SV_FlushGamestateCache();
     memset(&svs, 0, sizeof(svs));
 
     // reset rate limits
@@ -105,6 +105,9 @@ static cvar_t   *sv_mvd_disconnect_time;
 static cvar_t   *sv_mvd_suspend_time;
 static cvar_t   *sv_mvd_allow_stufftext;
 static cvar_t   *sv_mvd_spawn_dummy;
+#if USE_ZLIB
+static cvar_t   *sv_mvd_compress;
+#endif
 
 static bool     mvd_enable(void);
 static void     mvd_disable(void);
@@ -1513,9 +1516,9 @@ static void parse_hello(gtv_client_t *client)
 #if USE_ZLIB
     // the rest of the stream will be deflated
     if (flags & GTF_DEFLATE) {
-        client->z.zalloc = SV_zalloc;
-        client->z.zfree = SV_zfree;
-        if (deflateInit(&client->z, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        sv_codec_t codec = SV_CodecForName(sv_mvd_compress->string);
+
+        if (SV_DeflateInit(&client->z, codec, MAX_WBITS, 8) != Z_OK) {
             drop_client(client, "deflateInit failed");
             return;
         }
@@ -2394,6 +2397,10 @@ void SV_MvdRegister(void)
     sv_mvd_suspend_time->changed(sv_mvd_suspend_time);
     sv_mvd_allow_stufftext = Cvar_Get("sv_mvd_allow_stufftext", "0", CVAR_LATCH);
     sv_mvd_spawn_dummy = Cvar_Get("sv_mvd_spawn_dummy", "1", 0);
+#if USE_ZLIB
+    sv_mvd_compress = Cvar_Get("sv_mvd_compress", "deflate", 0);
+    sv_mvd_compress->changed = sv_codec_changed;
+#endif
 
     Cmd_Register(c_svmvd);
 }
@@ -0,0 +1,1046 @@
+/*
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+//
+// replay.c -- user command recorder and headless replay
+//
+// The recorder captures everything the game module is fed for one level,
+// in the order the server executed it: client connects, userinfo updates,
+// string commands, user commands and game frames. Game RNG is seeded
+// through g_seed at spawn, so the level can later be re-run frame-exactly
+// on a dedicated server without any networking, as fast as possible.
+// Each recorded frame carries a checksum of player movement state used to
+// detect divergence.
+//
+
+#include "server.h"
+
+#define UCMD_MAGIC      MakeRawLong('U', 'C', 'M', 'D')
+#define UCMD_VERSION    1
+
+#define UCMD_MAX_EVENT  (MAX_INFO_STRING * 2 + 16)
+
+enum {
+    ev_frame,           // checksum
+    ev_connect,         // clientnum, userinfo, extra userinfo
+    ev_begin,           // clientnum
+    ev_userinfo,        // clientnum, userinfo
+    ev_command,         // clientnum, command string
+    ev_move,            // clientnum, usercmd
+    ev_disconnect       // clientnum
+};
+
+static char         rec_pending[MAX_OSPATH];
+static qhandle_t    rec_file;
+static char         rec_name[MAX_OSPATH];
+static unsigned     rec_frames;
+static byte         rec_tracked[MAX_CLIENTS];
+static bool         rec_warned;
+
+static char         seed_saved[MAX_QPATH];
+
+typedef struct {
+    byte    *data, *end;
+    bool    overflowed;
+} reader_t;
+
+static struct {
+    bool        spawning;       // inside SV_InitGame and SV_SpawnServer
+    bool        timedemo;       // driven by SV_Frame, frames back to back
+    byte        *buffer;
+    reader_t    r;
+    char        path[MAX_OSPATH];
+    byte        clients[MAX_CLIENTS];
+    uint32_t    checksum;       // expected at the end of the current frame
+    unsigned    frames, moves, mismatches, first_mismatch;
+    uint64_t    start, game_start, game_time, frame_start;
+    uint64_t    *frametimes;
+    unsigned    maxframetimes;
+    size_t      allocs;
+} replay;
+
+static cvar_t       *g_seed;
+
+/*
+==============================================================================
+
+RECORDER
+
+==============================================================================
+*/
+
+static void rec_stop(void)
+{
+    if (!rec_file)
+        return;
+
+    if (FS_FCloseFile(rec_file))
+        Com_EPrintf("Error writing %s\n", rec_name);
+    else
+        Com_Printf("Stopped recording user commands to %s (%u frames).\n",
+                   rec_name, rec_frames);
+
+    rec_file = 0;
+}
+
+static void rec_write(sizebuf_t *buf)
+{
+    int ret;
+
+    ret = FS_Write(buf->data, buf->cursize, rec_file);
+    if (ret == buf->cursize)
+        return;
+
+    Com_EPrintf("Couldn't write %s: %s\n", rec_name, Q_ErrorString(ret));
+    rec_stop();
+}
+
+static void rec_string(sizebuf_t *buf, const char *s)
+{
+    SZ_Write(buf, s, strlen(s) + 1);
+}
+
+// Returns true if events for this client should be recorded.
+static bool rec_client(client_t *cl)
+{
+    return rec_file && rec_tracked[cl->number];
+}
+
+static void rec_client_event(sizebuf_t *buf, byte *data, int type, client_t *cl)
+{
+    SZ_Init(buf, data, UCMD_MAX_EVENT);
+    SZ_WriteByte(buf, type);
+    SZ_WriteByte(buf, cl->number);
+}
+
+// FNV-1a over movement state of all connected players
+static void checksum_data(uint32_t *hash, const void *data, size_t len)
+{
+    const byte *p = data;
+
+    while (len--) {
+        *hash ^= *p++;
+        *hash *= 16777619;
+    }
+}
+
+static uint32_t frame_checksum(void)
+{
+    uint32_t hash = 2166136261U;
+    pmove_state_t *pm;
+    edict_t *ent;
+    int i;
+
+    for (i = 0; i < sv_maxclients->integer; i++) {
+        ent = EDICT_NUM(i + 1);
+        if (!ent->inuse || !ent->client)
+            continue;
+        pm = &ent->client->ps.pmove;
+        checksum_data(&hash, &i, sizeof(i));
+        checksum_data(&hash, &pm->pm_type, sizeof(pm->pm_type));
+        checksum_data(&hash, pm->origin, sizeof(pm->origin));
+        checksum_data(&hash, pm->velocity, sizeof(pm->velocity));
+        checksum_data(&hash, &pm->pm_flags, sizeof(pm->pm_flags));
+        checksum_data(&hash, &pm->pm_time, sizeof(pm->pm_time));
+        checksum_data(&hash, ent->client->ps.viewangles,
+                      sizeof(ent->client->ps.viewangles));
+        checksum_data(&hash, &ent->client->ps.stats[STAT_HEALTH],
+                      sizeof(ent->client->ps.stats[STAT_HEALTH]));
+    }
+
+    checksum_data(&hash, &ge->num_edicts, sizeof(ge->num_edicts));
+    return hash;
+}
+
+/*
+==================
+SV_ReplayMapSpawn
+
+Called before the game spawns entities. Starts a pending recording and
+fixes the game RNG seed for it.
+==================
+*/
+void SV_ReplayMapSpawn(mapcmd_t *cmd)
+{
+    byte data[MAX_QPATH * 2 + 32];
+    sizebuf_t buf;
+    uint32_t seed;
+
+    // a recording covers exactly one level
+    rec_stop();
+
+    if (replay.spawning || !rec_pending[0] || cmd->state != ss_game)
+        return;
+
+    rec_file = FS_EasyOpenFile(rec_name, sizeof(rec_name), FS_MODE_WRITE,
+                               "replays/", rec_pending, ".ucmd");
+    rec_pending[0] = 0;
+    if (!rec_file)
+        return;
+
+    seed = g_seed->integer;
+    if (!seed)
+        seed = Q_rand() | 1;
+
+    SZ_Init(&buf, data, sizeof(data));
+    SZ_WriteLong(&buf, UCMD_MAGIC);
+    SZ_WriteLong(&buf, UCMD_VERSION);
+    SZ_WriteLong(&buf, seed);
+    SZ_WriteByte(&buf, Cvar_VariableInteger("deathmatch"));
+    SZ_WriteByte(&buf, Cvar_VariableInteger("coop"));
+    SZ_WriteByte(&buf, Cvar_VariableInteger("skill"));
+    SZ_WriteByte(&buf, sv_maxclients->integer);
+    rec_string(&buf, cmd->server);
+    rec_string(&buf, cmd->spawnpoint);
+    rec_write(&buf);
+    if (!rec_file)
+        return;
+
+    rec_frames = 0;
+    rec_warned = false;
+    memset(rec_tracked, 0, sizeof(rec_tracked));
+
+    Q_strlcpy(seed_saved, g_seed->string, sizeof(seed_saved));
+    Cvar_SetInteger(g_seed, seed, FROM_CODE);
+
+    Com_Printf("Recording user commands to %s.\n", rec_name);
+}
+
+/*
+==================
+SV_ReplayMapSpawned
+
+Called once the game has spawned entities. Restores user seed setting.
+==================
+*/
+void SV_ReplayMapSpawned(void)
+{
+    if (!seed_saved[0])
+        return;
+
+    Cvar_Set("g_seed", seed_saved);
+    seed_saved[0] = 0;
+}
+
+/*
+==================
+SV_ReplayLevelRestored
+
+Level state was loaded from a savegame, which can't be reproduced.
+==================
+*/
+void SV_ReplayLevelRestored(void)
+{
+    if (!rec_file)
+        return;
+
+    Com_WPrintf("Level restored from savegame, user command recording "
+                "will not be replayable.\n");
+    rec_stop();
+}
+
+static void rec_connect(client_t *cl, const char *userinfo, const char *extra)
+{
+    byte data[UCMD_MAX_EVENT];
+    sizebuf_t buf;
+
+    rec_tracked[cl->number] = true;
+    rec_client_event(&buf, data, ev_connect, cl);
+    rec_string(&buf, userinfo);
+    rec_string(&buf, extra);
+    rec_write(&buf);
+}
+
+// Called before the game sees the connection. Extra userinfo follows
+// the main userinfo string if the game supports it.
+void SV_ReplayConnect(client_t *cl, const char *userinfo)
+{
+    if (!rec_file)
+        return;
+
+    if (g_features->integer & GMF_EXTRA_USERINFO)
+        rec_connect(cl, userinfo, userinfo + strlen(userinfo) + 1);
+    else
+        rec_connect(cl, userinfo, "");
+}
+
+void SV_ReplayBegin(client_t *cl)
+{
+    byte data[UCMD_MAX_EVENT];
+    sizebuf_t buf;
+
+    if (!rec_file)
+        return;
+
+    // clients carried over from the previous level only get to begin,
+    // their persistant state is lost in replay
+    if (!rec_tracked[cl->number]) {
+        if (!rec_warned) {
+            Com_WPrintf("%s entered from the previous level, replay will "
+                        "not restore inventory.\n", cl->name);
+            rec_warned = true;
+        }
+        rec_connect(cl, cl->userinfo, "");
+        SV_ReplayUserinfo(cl);
+    }
+
+    rec_client_event(&buf, data, ev_begin, cl);
+    rec_write(&buf);
+}
+
+void SV_ReplayUserinfo(client_t *cl)
+{
+    byte data[UCMD_MAX_EVENT];
+    sizebuf_t buf;
+
+    if (!rec_client(cl))
+        return;
+
+    rec_client_event(&buf, data, ev_userinfo, cl);
+    rec_string(&buf, cl->userinfo);
+    rec_write(&buf);
+}
+
+void SV_ReplayCommand(client_t *cl, const char *s)
+{
+    byte data[UCMD_MAX_EVENT];
+    sizebuf_t buf;
+
+    if (!rec_client(cl))
+        return;
+
+    if (strlen(s) >= MAX_STRING_CHARS)
+        return;
+
+    rec_client_event(&buf, data, ev_command, cl);
+    rec_string(&buf, s);
+    rec_write(&buf);
+}
+
+void SV_ReplayMove(client_t *cl, const usercmd_t *cmd)
+{
+    byte data[UCMD_MAX_EVENT];
+    sizebuf_t buf;
+
+    if (!rec_client(cl))
+        return;
+
+    rec_client_event(&buf, data, ev_move, cl);
+    SZ_WriteByte(&buf, cmd->msec);
+    SZ_WriteByte(&buf, cmd->buttons);
+    SZ_WriteShort(&buf, cmd->angles[0]);
+    SZ_WriteShort(&buf, cmd->angles[1]);
+    SZ_WriteShort(&buf, cmd->angles[2]);
+    SZ_WriteShort(&buf, cmd->forwardmove);
+    SZ_WriteShort(&buf, cmd->sidemove);
+    SZ_WriteShort(&buf, cmd->upmove);
+    SZ_WriteByte(&buf, cmd->impulse);
+    SZ_WriteByte(&buf, cmd->lightlevel);
+    rec_write(&buf);
+}
+
+void SV_ReplayDisconnect(client_t *cl)
+{
+    byte data[UCMD_MAX_EVENT];
+    sizebuf_t buf;
+
+    if (!rec_client(cl))
+        return;
+
+    rec_client_event(&buf, data, ev_disconnect, cl);
+    rec_write(&buf);
+    rec_tracked[cl->number] = false;
+}
+
+static void rec_frame(void)
+{
+    byte data[8];
+    sizebuf_t buf;
+
+    SZ_Init(&buf, data, sizeof(data));
+    SZ_WriteByte(&buf, ev_frame);
+    SZ_WriteLong(&buf, frame_checksum());
+    rec_write(&buf);
+    rec_frames++;
+}
+
+static void SV_RecordUcmds_f(void)
+{
+    if (Cmd_Argc() != 2) {
+        Com_Printf("Usage: %s <filename>\n", Cmd_Argv(0));
+        return;
+    }
+
+    if (rec_file) {
+        Com_Printf("Already recording user commands to %s.\n", rec_name);
+        return;
+    }
+
+    Q_strlcpy(rec_pending, Cmd_Argv(1), sizeof(rec_pending));
+    Com_Printf("User command recording will start with the next map.\n");
+}
+
+static void SV_StopUcmds_f(void)
+{
+    if (rec_pending[0]) {
+        Com_Printf("Cancelled pending user command recording.\n");
+        rec_pending[0] = 0;
+        return;
+    }
+
+    if (!rec_file) {
+        Com_Printf("Not recording user commands.\n");
+        return;
+    }
+
+    rec_stop();
+}
+
+/*
+==============================================================================
+
+REPLAY
+
+Replay clients are not connected over the network. In the default mode
+they have no message queues at all and the game is run directly, without
+any of the server frame around it. In timedemo mode they are regular
+protocol 34 clients on the loopback address that always acknowledge the
+last frame, and the full SV_Frame runs back to back so that building and
+writing client frames is measured too. Dedicated servers have nobody on
+the other end of the loopback, so packets are dropped once written.
+
+==============================================================================
+*/
+
+static int read_byte(reader_t *r)
+{
+    if (r->data + 1 > r->end) {
+        r->overflowed = true;
+        return -1;
+    }
+    return *r->data++;
+}
+
+static int read_short(reader_t *r)
+{
+    int c;
+
+    if (r->data + 2 > r->end) {
+        r->overflowed = true;
+        return -1;
+    }
+    c = (int16_t)LittleShortMem(r->data);
+    r->data += 2;
+    return c;
+}
+
+static uint32_t read_long(reader_t *r)
+{
+    uint32_t c;
+
+    if (r->data + 4 > r->end) {
+        r->overflowed = true;
+        return 0;
+    }
+    c = LittleLongMem(r->data);
+    r->data += 4;
+    return c;
+}
+
+static const char *read_string(reader_t *r, size_t maxlen)
+{
+    const char *s = (const char *)r->data;
+    size_t remaining = r->end - r->data;
+    size_t len = strnlen(s, min(remaining, maxlen));
+
+    if (len == remaining || len == maxlen) {
+        r->overflowed = true;
+        return "";
+    }
+    r->data += len + 1;
+    return s;
+}
+
+static void replay_add_message(client_t *client, byte *data,
+                               size_t length, bool reliable)
+{
+}
+
+static void replay_free(void)
+{
+    // let commands held back by the timedemo run
+    if (replay.timedemo)
+        cmd_buffer.waitCount = 0;
+
+    Z_Free(replay.buffer);
+    Z_Free(replay.frametimes);
+    memset(&replay, 0, sizeof(replay));
+}
+
+// Called on errors from the synchronous replay. Its clients are not on
+// the client list, so the regular server shutdown never sees them.
+static void replay_abort(void *arg)
+{
+    client_t *cl;
+    int i;
+
+    if (arg)
+        CM_FreeMap(arg);
+
+    SV_ReplayMapSpawned();
+
+    for (i = 0; svs.client_pool && i < sv_maxclients->integer; i++) {
+        cl = &svs.client_pool[i];
+        if (replay.clients[i] && !replay.timedemo) {
+            Z_Free(cl->netchan);
+            memset(cl, 0, sizeof(*cl));
+        }
+    }
+
+    replay_free();
+}
+
+static void replay_drop(client_t *cl)
+{
+    replay.clients[cl - svs.client_pool] = false;
+
+    if (replay.timedemo) {
+        SV_DropClient(cl, NULL);
+        SV_RemoveClient(cl);
+        return;
+    }
+
+    if (cl->state == cs_spawned || (g_features->integer & GMF_WANT_ALL_DISCONNECTS)) {
+        sv_client = cl;
+        sv_player = cl->edict;
+        ge->ClientDisconnect(cl->edict);
+        sv_client = NULL;
+        sv_player = NULL;
+    }
+
+    Z_Free(cl->netchan);
+    memset(cl, 0, sizeof(*cl));
+}
+
+static bool replay_connect(client_t *cl, const char *userinfo, const char *extra)
+{
+    char buffer[MAX_INFO_STRING * 2];
+    netadr_t adr;
+    size_t len;
+    int number = cl - svs.client_pool;
+    int allow;
+
+    if (cl->state) {
+        Com_EPrintf("Replay connects client %d twice\n", number);
+        return false;
+    }
+
+    len = strlen(userinfo);
+    if (len + strlen(extra) + 3 > sizeof(buffer)) {
+        Com_EPrintf("Replay has oversize userinfo\n");
+        return false;
+    }
+    memcpy(buffer, userinfo, len + 1);
+    strcpy(buffer + len + 1, extra);
+    buffer[len + strlen(extra) + 2] = 0;
+
+    memset(cl, 0, sizeof(*cl));
+    cl->number = cl->slot = number;
+    cl->edict = EDICT_NUM(number + 1);
+    List_Init(&cl->entry);
+
+    memset(&adr, 0, sizeof(adr));
+    adr.type = NA_LOOPBACK;
+
+    if (replay.timedemo) {
+        cl->protocol = PROTOCOL_VERSION_DEFAULT;
+        cl->gamedir = fs_game->string;
+        cl->mapname = sv.name;
+        cl->configstrings = (char *)sv.configstrings;
+        cl->pool = (edict_pool_t *)&ge->edicts;
+        cl->cm = &sv.cm;
+        cl->spawncount = sv.spawncount;
+        cl->maxclients = sv_maxclients->integer;
+#if USE_FPS
+        cl->framediv = sv.framediv;
+        cl->settings[CLS_FPS] = BASE_FRAMERATE;
+#endif
+        cl->pmp = sv_pmp;
+        cl->netchan = Netchan_Setup(NS_SERVER, NETCHAN_OLD, &adr, 0,
+                                    MAX_PACKETLEN_WRITABLE_DEFAULT,
+                                    PROTOCOL_VERSION_DEFAULT);
+    } else {
+        cl->protocol = -1;
+        cl->state = cs_connected;
+        cl->AddMessage = replay_add_message;
+        cl->netchan = SV_Mallocz(sizeof(netchan_t));
+        cl->netchan->remote_address = adr;
+    }
+
+    sv_client = cl;
+    sv_player = cl->edict;
+    allow = ge->ClientConnect(cl->edict, buffer);
+    sv_client = NULL;
+    sv_player = NULL;
+    if (!allow) {
+        // recorded before the game had a say, so replay the rejection
+        Com_DPrintf("Replay client %d rejected by game\n", number);
+        if (replay.timedemo)
+            Netchan_Close(cl->netchan);
+        else
+            Z_Free(cl->netchan);
+        memset(cl, 0, sizeof(*cl));
+        return true;
+    }
+
+    Q_strlcpy(cl->userinfo, buffer, sizeof(cl->userinfo));
+    replay.clients[number] = true;
+
+    if (replay.timedemo) {
+        SV_InitClientSend(cl);
+        cl->WriteFrame = SV_WriteFrameToClient_Default;
+        cl->reconnected = true;
+        List_SeqAdd(&sv_clientlist, &cl->entry);
+        cl->state = cs_connected;
+        cl->framenum = 1;
+        cl->lastframe = -1;
+        cl->lastmessage = svs.realtime;
+        cl->lastactivity = svs.realtime;
+        cl->min_ping = 9999;
+    }
+
+    return true;
+}
+
+static bool replay_event(int type, client_t *cl)
+{
+    reader_t *r = &replay.r;
+    const char *s;
+    usercmd_t cmd;
+    int i;
+
+    switch (type) {
+    case ev_begin:
+        cl->state = cs_spawned;
+        ge->ClientBegin(cl->edict);
+        break;
+    case ev_userinfo:
+        s = read_string(r, MAX_INFO_STRING);
+        if (r->overflowed)
+            return false;
+        Q_strlcpy(cl->userinfo, s, sizeof(cl->userinfo));
+        SV_UserinfoChanged(cl);
+        break;
+    case ev_command:
+        s = read_string(r, MAX_STRING_CHARS);
+        if (r->overflowed)
+            return false;
+        Cmd_TokenizeString(s, false);
+        ge->ClientCommand(cl->edict);
+        break;
+    case ev_move:
+        cmd.msec = read_byte(r);
+        cmd.buttons = read_byte(r);
+        for (i = 0; i < 3; i++)
+            cmd.angles[i] = read_short(r);
+        cmd.forwardmove = read_short(r);
+        cmd.sidemove = read_short(r);
+        cmd.upmove = read_short(r);
+        cmd.impulse = read_byte(r);
+        cmd.lightlevel = read_byte(r);
+        if (r->overflowed)
+            return false;
+        ge->ClientThink(cl->edict, &cmd);
+        replay.moves++;
+        break;
+    case ev_disconnect:
+        replay_drop(cl);
+        break;
+    default:
+        Com_EPrintf("Replay has unknown event %d\n", type);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+==================
+replay_next
+
+Feeds recorded events to the game up to the next frame. Returns false at
+the end of the recording or on malformed input.
+==================
+*/
+static bool replay_next(void)
+{
+    reader_t *r = &replay.r;
+    const char *s, *extra;
+    client_t *cl;
+    int type, number;
+    bool ok;
+
+    while (r->data < r->end) {
+        type = read_byte(r);
+        if (type == ev_frame) {
+            replay.checksum = read_long(r);
+            return !r->overflowed;
+        }
+
+        number = read_byte(r);
+        if (r->overflowed)
+            return false;
+
+        if (number >= sv_maxclients->integer) {
+            Com_EPrintf("Replay references bad client slot %d\n", number);
+            r->overflowed = true;
+            return false;
+        }
+
+        cl = &svs.client_pool[number];
+        if (type == ev_connect) {
+            s = read_string(r, MAX_INFO_STRING);
+            extra = read_string(r, MAX_INFO_STRING);
+            if (r->overflowed || !replay_connect(cl, s, extra)) {
+                r->overflowed = true;
+                return false;
+            }
+            continue;
+        }
+
+        if (!replay.clients[number]) {
+            Com_EPrintf("Replay references unconnected client %d\n", number);
+            r->overflowed = true;
+            return false;
+        }
+
+        sv_client = cl;
+        sv_player = cl->edict;
+        ok = replay_event(type, cl);
+        sv_client = NULL;
+        sv_player = NULL;
+
+        if (!ok) {
+            r->overflowed = true;
+            return false;
+        }
+    }
+
+    return false;
+}
+
+static void replay_check_frame(void)
+{
+    replay.frames++;
+    if (frame_checksum() != replay.checksum && !replay.mismatches++)
+        replay.first_mismatch = replay.frames;
+}
+
+static int frametime_cmp(const void *p1, const void *p2)
+{
+    uint64_t a = *(const uint64_t *)p1;
+    uint64_t b = *(const uint64_t *)p2;
+
+    if (a < b)
+        return -1;
+    if (a > b)
+        return 1;
+    return 0;
+}
+
+static void replay_print_frametimes(void)
+{
+    uint64_t *t = replay.frametimes;
+    unsigned n = min(replay.frames, replay.maxframetimes);
+
+    if (!n)
+        return;
+
+    qsort(t, n, sizeof(t[0]), frametime_cmp);
+    Com_Printf("frame usec: min %"PRIu64", p50 %"PRIu64", p99 %"PRIu64
+               ", max %"PRIu64"\n", t[0], t[n / 2],
+               t[min(n - 1, n * 99 / 100)], t[n - 1]);
+}
+
+static void replay_finish(void)
+{
+    uint64_t total = Sys_Microseconds() - replay.start;
+    size_t allocs = Z_AllocCount() - replay.allocs;
+    int i;
+
+    for (i = 0; i < sv_maxclients->integer; i++)
+        if (replay.clients[i])
+            replay_drop(&svs.client_pool[i]);
+
+    SpeedrunUnpauseTimer();
+
+    if (replay.r.overflowed)
+        Com_EPrintf("Replay stopped on malformed input\n");
+
+    Com_Printf("%u frames, %u user commands in %.3f sec\n",
+               replay.frames, replay.moves, total * 1e-6);
+    if (replay.frames && total) {
+        Com_Printf("%.1f fps, %.1f usec/frame (%.1f in game), "
+                   "%"PRIz" allocations (%.1f/frame)\n",
+                   replay.frames * 1e6 / total, (double)total / replay.frames,
+                   (double)replay.game_time / replay.frames, allocs,
+                   (double)allocs / replay.frames);
+    }
+
+    if (replay.timedemo)
+        replay_print_frametimes();
+
+    if (replay.mismatches)
+        Com_Printf("Replay diverged at frame %u (%u of %u frames differ).\n",
+                   replay.first_mismatch, replay.mismatches, replay.frames);
+    else
+        Com_Printf("Replay matched recording.\n");
+
+    replay_free();
+}
+
+/*
+==================
+SV_ReplayTimedemo
+
+Returns true while a timedemo replay is running, server frames should
+not wait for the frame time to pass.
+==================
+*/
+bool SV_ReplayTimedemo(void)
+{
+    return replay.timedemo && replay.buffer;
+}
+
+/*
+==================
+SV_ReplayRunClients
+
+Feeds timedemo replay input for the coming server frame. Returns false
+if the replay has just ended and the frame should not be run.
+==================
+*/
+bool SV_ReplayRunClients(void)
+{
+    uint64_t now;
+    client_t *cl;
+    int i;
+
+    if (!SV_ReplayTimedemo())
+        return true;
+
+    now = Sys_Microseconds();
+    if (replay.frame_start && replay.frames) {
+        if (replay.frames >= replay.maxframetimes) {
+            replay.maxframetimes = max(replay.maxframetimes * 2, 1024);
+            replay.frametimes = Z_Realloc(replay.frametimes,
+                                          sizeof(replay.frametimes[0]) *
+                                          replay.maxframetimes);
+        }
+        replay.frametimes[replay.frames - 1] = now - replay.frame_start;
+    }
+    replay.frame_start = now;
+
+    if (!replay_next()) {
+        replay_finish();
+        return false;
+    }
+
+    // clients on loopback acknowledge every frame immediately
+    for (i = 0; i < sv_maxclients->integer; i++) {
+        cl = &svs.client_pool[i];
+        if (!replay.clients[i])
+            continue;
+        cl->lastframe = cl->framenum - 1;
+        cl->lastmessage = svs.realtime;
+        cl->lastactivity = svs.realtime;
+    }
+
+    replay.game_start = Sys_Microseconds();
+    return true;
+}
+
+void SV_ReplayFrame(void)
+{
+    if (SV_ReplayTimedemo()) {
+        replay.game_time += Sys_Microseconds() - replay.game_start;
+        replay_check_frame();
+    }
+
+    if (rec_file)
+        rec_frame();
+}
+
+/*
+==================
+SV_Replay_f
+
+Loads the recorded level and re-runs it frame-exactly, as fast as
+possible.
+==================
+*/
+static void SV_Replay_f(void)
+{
+    mapcmd_t    cmd;
+    reader_t    *r = &replay.r;
+    uint32_t    seed;
+    int         len, dm, coop, skill, maxclients;
+    const char  *map, *spawnpoint;
+    bool        timedemo;
+
+    if (Cmd_Argc() < 2) {
+        Com_Printf("Usage: %s <filename> [timedemo]\n", Cmd_Argv(0));
+        return;
+    }
+
+    if (!dedicated->integer) {
+        Com_Printf("Replays can only be run on a dedicated server.\n");
+        return;
+    }
+
+    timedemo = Cmd_Argc() > 2 && !strcmp(Cmd_Argv(2), "timedemo");
+
+    if (replay.buffer) {
+        Com_Printf("Stopped replay of %s.\n", replay.path);
+        replay_free();
+    }
+
+    if (Q_concat(replay.path, sizeof(replay.path), "replays/", Cmd_Argv(1), NULL) >= sizeof(replay.path) ||
+        COM_DefaultExtension(replay.path, ".ucmd", sizeof(replay.path)) >= sizeof(replay.path)) {
+        Com_Printf("Oversize filename specified.\n");
+        return;
+    }
+
+    len = FS_LoadFile(replay.path, (void **)&replay.buffer);
+    if (!replay.buffer) {
+        Com_Printf("Couldn't load %s: %s\n", replay.path, Q_ErrorString(len));
+        return;
+    }
+
+    r->data = replay.buffer;
+    r->end = replay.buffer + len;
+
+    if (read_long(r) != UCMD_MAGIC || read_long(r) != UCMD_VERSION) {
+        Com_Printf("%s is not a user command recording.\n", replay.path);
+        goto fail;
+    }
+
+    seed = read_long(r);
+    dm = read_byte(r);
+    coop = read_byte(r);
+    skill = read_byte(r);
+    maxclients = read_byte(r);
+    map = read_string(r, MAX_QPATH);
+    spawnpoint = read_string(r, MAX_QPATH);
+    if (r->overflowed) {
+        Com_Printf("%s has a bad header.\n", replay.path);
+        goto fail;
+    }
+
+    memset(&cmd, 0, sizeof(cmd));
+    if (Q_concat(cmd.buffer, sizeof(cmd.buffer), map, *spawnpoint ? "$" : "",
+                 spawnpoint, NULL) >= sizeof(cmd.buffer)) {
+        Com_Printf("Oversize level string.\n");
+        goto fail;
+    }
+
+    Cvar_Set("deathmatch", va("%d", dm));
+    Cvar_Set("coop", va("%d", coop));
+    Cvar_Set("skill", va("%d", skill));
+    Cvar_Set("maxclients", va("%d", maxclients));
+
+    if (!SV_ParseMapCmd(&cmd))
+        goto fail;
+
+    // any error will drop from this point
+    replay.spawning = true;
+    Com_AbortFunc(replay_abort, &cmd.cm);
+    cmd.endofunit = true;
+    SV_InitGame(MVD_SPAWN_DISABLED);
+    Com_AbortFunc(replay_abort, NULL);
+
+    Q_strlcpy(seed_saved, g_seed->string, sizeof(seed_saved));
+    Cvar_SetInteger(g_seed, seed, FROM_CODE);
+    SV_SpawnServer(&cmd);
+    replay.spawning = false;
+
+    // keep replays out of speedrun splits
+    SpeedrunPauseTimer();
+
+    Com_Printf("Replaying %s on %s%s\n", replay.path, map,
+               timedemo ? " as timedemo" : "");
+
+    replay.timedemo = timedemo;
+    replay.allocs = Z_AllocCount();
+    replay.start = Sys_Microseconds();
+
+    if (timedemo) {
+        // errors from now on shut down the server, which stops the replay
+        Com_AbortFunc(NULL, NULL);
+
+        // hold back commands after this one, such as +quit on the command
+        // line, until the timedemo has finished
+        cmd_buffer.waitCount = INT_MAX;
+        return;
+    }
+
+    while (replay_next()) {
+        replay.game_start = Sys_Microseconds();
+        ge->RunFrame(true);
+        replay.game_time += Sys_Microseconds() - replay.game_start;
+        SZ_Clear(&msg_write);
+        replay_check_frame();
+    }
+
+    Com_AbortFunc(NULL, NULL);
+    replay_finish();
+    return;
+
+fail:
+    replay_free();
+}
+
+/*
+==================
+SV_ReplayActive
+
+Replays run the game exactly as recorded, even on dedicated servers.
+==================
+*/
+bool SV_ReplayActive(void)
+{
+    return replay.spawning;
+}
+
+void SV_ReplayShutdown(void)
+{
+    rec_stop();
+
+    // the server going down takes any timedemo clients with it
+    if (replay.buffer && !replay.spawning) {
+        Com_Printf("Stopped replay of %s.\n", replay.path);
+        replay_free();
+    }
+}
+
+void SV_ReplayRegister(void)
+{
+    g_seed = Cvar_Get("g_seed", "0", 0);
+
+    Cmd_AddCommand("ucmdrecord", SV_RecordUcmds_f);
+    Cmd_AddCommand("ucmdstop", SV_StopUcmds_f);
+    Cmd_AddCommand("replay", SV_Replay_f);
+}
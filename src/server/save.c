@@ -384,7 +384,11 @@ static int read_server_file(void)
     if (len >= MAX_OSPATH)
         Com_Error(ERR_DROP, "Savegame path too long");
 
+    SpeedrunBeginLoad(SPEEDRUN_LOAD_SAVEGAME);
+    LoadProf_Begin("ReadGame", name);
     ge->ReadGame(name);
+    LoadProf_End();
+    SpeedrunEndLoad(SPEEDRUN_LOAD_SAVEGAME);
 
     // clear pending CM
     Com_AbortFunc(NULL, NULL);
@@ -447,7 +451,9 @@ static int read_level_file(void)
     if (len >= MAX_OSPATH)
         Com_Error(ERR_DROP, "Savegame path too long");
 
+    LoadProf_Begin("ReadLevel", name);
     ge->ReadLevel(name);
+    LoadProf_End();
     return 0;
 }
 
@@ -536,10 +542,16 @@ void SV_AutoSaveEnd(void)
 
 void SV_CheckForSavegame(mapcmd_t *cmd)
 {
+    int ret;
+
     if (no_save_games())
         return;
 
-    if (read_level_file()) {
+    SpeedrunBeginLoad(SPEEDRUN_LOAD_SAVEGAME);
+    ret = read_level_file();
+    SpeedrunEndLoad(SPEEDRUN_LOAD_SAVEGAME);
+
+    if (ret) {
         // only warn when loading a regular savegame. autosave without level
         // file is ok and simply starts the map from the beginning.
         if (cmd->loadgame == 1)
@@ -547,6 +559,8 @@ void SV_CheckForSavegame(mapcmd_t *cmd)
         return;
     }
 
+    SV_ReplayLevelRestored();
+
     if (cmd->loadgame) {
         // called from SV_Loadgame_f
         ge->RunFrame(true);
@@ -78,6 +78,7 @@ static bool SV_RateDrop(client_t *client)
                    client->framenum, client->name, total);
         client->frameflags |= FF_SUPPRESSED;
         client->suppress_count++;
+        client->frames_suppressed++;
         client->message_size[client->framenum % RATE_MESSAGES] = 0;
         return true;
     }
@@ -238,6 +239,9 @@ void SV_BroadcastCommand(const char *fmt, ...)
 }
 
 
+static bool                 multicast_active;
+static message_payload_t    *multicast_payload;
+
 /*
 =================
 SV_Multicast
@@ -295,6 +299,10 @@ void SV_Multicast(vec3_t origin, multicast_t to)
         Com_Error(ERR_DROP, "SV_Multicast: bad to: %i", to);
     }
 
+    // large payload is copied once and shared by all client queues
+    multicast_active = true;
+    multicast_payload = NULL;
+
     // send the data to all relevent clients
     FOR_EACH_CLIENT(client) {
         if (client->state < cs_primed) {
@@ -328,6 +336,9 @@ void SV_Multicast(vec3_t origin, multicast_t to)
         SV_ClientAddMessage(client, flags);
     }
 
+    multicast_active = false;
+    multicast_payload = NULL;
+
     // add to MVD datagram
     SV_MvdMulticast(leafnum, to);
 
@@ -358,7 +369,7 @@ static bool compress_message(client_t *client, int flags)
     if (msg_write.cursize < client->netchan->maxpacketlen / 2)
         return false;
 
-    deflateReset(&svs.z);
+    SV_DeflateReset(client->codec);
     svs.z.next_in = msg_write.data;
     svs.z.avail_in = (uInt)msg_write.cursize;
     svs.z.next_out = buffer + 5;
@@ -426,6 +437,33 @@ FRAME UPDATES - COMMON
 ===============================================================================
 */
 
+static inline byte *msg_data(message_packet_t *msg)
+{
+    return msg->cursize > MSG_TRESHOLD ? msg->payload->data : msg->data;
+}
+
+static message_payload_t *get_payload(byte *data, size_t len)
+{
+    message_payload_t *payload;
+
+    // everything added during multicast is the write buffer contents,
+    // unless compressed for a particular client
+    if (multicast_active && data == msg_write.data && len == msg_write.cursize) {
+        if (multicast_payload) {
+            multicast_payload->refcount++;
+            return multicast_payload;
+        }
+        payload = SV_Malloc(sizeof(*payload) + len - 1);
+        multicast_payload = payload;
+    } else {
+        payload = SV_Malloc(sizeof(*payload) + len - 1);
+    }
+
+    payload->refcount = 1;
+    memcpy(payload->data, data, len);
+    return payload;
+}
+
 static inline void free_msg_packet(client_t *client, message_packet_t *msg)
 {
     List_Remove(&msg->entry);
@@ -435,6 +473,9 @@ static inline void free_msg_packet(client_t *client, message_packet_t *msg)
             Com_Error(ERR_FATAL, "%s: bad packet size", __func__);
         }
         client->msg_dynamic_bytes -= msg->cursize;
+        if (!--msg->payload->refcount) {
+            Z_Free(msg->payload);
+        }
         Z_Free(msg);
     } else {
         List_Insert(&client->msg_free_list, &msg->entry);
@@ -480,7 +521,8 @@ static void add_msg_packet(client_t     *client,
                         __func__, client->name);
             goto overflowed;
         }
-        msg = SV_Malloc(sizeof(*msg) + len - MSG_TRESHOLD);
+        msg = SV_Malloc(sizeof(*msg));
+        msg->payload = get_payload(data, len);
         client->msg_dynamic_bytes += len;
     } else {
         if (LIST_EMPTY(&client->msg_free_list)) {
@@ -490,9 +532,9 @@ static void add_msg_packet(client_t     *client,
         }
         msg = MSG_FIRST(&client->msg_free_list);
         List_Remove(&msg->entry);
+        memcpy(msg->data, data, len);
     }
 
-    memcpy(msg->data, data, len);
     msg->cursize = (uint16_t)len;
 
     if (reliable) {
@@ -579,7 +621,7 @@ static inline void write_msg(client_t *client, message_packet_t *msg, size_t max
 {
     // if this msg fits, write it
     if (msg_write.cursize + msg->cursize <= maxsize) {
-        MSG_WriteData(msg->data, msg->cursize);
+        MSG_WriteData(msg_data(msg), msg->cursize);
     }
     free_msg_packet(client, msg);
 }
@@ -647,7 +689,7 @@ static void write_reliables_old(client_t *client, size_t maxsize)
         SV_DPrintf(1, "%s to %s: writing msg %d: %d bytes\n",
                    __func__, client->name, count, msg->cursize);
 
-        SZ_Write(&client->netchan->message, msg->data, msg->cursize);
+        SZ_Write(&client->netchan->message, msg_data(msg), msg->cursize);
         free_msg_packet(client, msg);
         count++;
     }
@@ -657,6 +699,7 @@ static void write_reliables_old(client_t *client, size_t maxsize)
 static void repack_unreliables(client_t *client, size_t maxsize)
 {
     message_packet_t *msg, *next;
+    byte *data;
 
     if (msg_write.cursize + 4 > maxsize) {
         return;
@@ -664,13 +707,14 @@ static void repack_unreliables(client_t *client, size_t maxsize)
 
     // temp entities first
     FOR_EACH_MSG_SAFE(&client->msg_unreliable_list) {
-        if (!msg->cursize || msg->data[0] != svc_temp_entity) {
+        if (!msg->cursize || msg_data(msg)[0] != svc_temp_entity) {
             continue;
         }
         // ignore some low-priority effects, these checks come from r1q2
-        if (msg->data[1] == TE_BLOOD || msg->data[1] == TE_SPLASH ||
-            msg->data[1] == TE_GUNSHOT || msg->data[1] == TE_BULLET_SPARKS ||
-            msg->data[1] == TE_SHOTGUN) {
+        data = msg_data(msg);
+        if (data[1] == TE_BLOOD || data[1] == TE_SPLASH ||
+            data[1] == TE_GUNSHOT || data[1] == TE_BULLET_SPARKS ||
+            data[1] == TE_SHOTGUN) {
             continue;
         }
         write_msg(client, msg, maxsize);
@@ -693,7 +737,7 @@ static void repack_unreliables(client_t *client, size_t maxsize)
 
     // then positioned sounds
     FOR_EACH_MSG_SAFE(&client->msg_unreliable_list) {
-        if (msg->cursize && msg->data[0] == svc_sound) {
+        if (msg->cursize && msg_data(msg)[0] == svc_sound) {
             write_msg(client, msg, maxsize);
         }
     }
@@ -730,7 +774,10 @@ static void write_datagram_old(client_t *client)
     }
 
     // send over all the relevant entity_state_t
-    // and the player_state_t
+    // and the player_state_t, deferring entities that don't fit
+    client->frame_budget = maxsize;
+    if (client->adapt_budget && client->adapt_budget < maxsize)
+        client->frame_budget = client->adapt_budget;
     client->WriteFrame(client);
     if (msg_write.cursize > maxsize) {
         SV_DPrintf(0, "Frame %d overflowed for %s: %"PRIz" > %"PRIz"\n",
@@ -790,7 +837,8 @@ static void write_datagram_new(client_t *client)
     size_t cursize;
 
     // send over all the relevant entity_state_t
-    // and the player_state_t
+    // and the player_state_t, deferring entities over adaptive budget
+    client->frame_budget = client->adapt_budget;
     client->WriteFrame(client);
 
     if (msg_write.overflowed) {
@@ -869,6 +917,125 @@ static void check_key_sync(client_t *client)
 }
 #endif
 
+/*
+=======================
+adapt_client_rate
+
+Once per ADAPT_WINDOW, estimates link quality from the packets lost,
+frames rate suppressed and the ping measured during the window. Loss is
+downstream loss: outgoing netchan sequences the client ack jumped over.
+This assumes the client sends at least as many packets as it receives,
+which holds for default cl_maxpackets. When the link
+looks congested, lowers snapshot rate (Q2PRO clients only) and entity
+budget of the client. After a few good windows in a row, raises them
+back one step at a time, snapshot rate first.
+=======================
+*/
+#define ADAPT_WINDOW        1000
+#define ADAPT_GOOD_WINDOWS  3
+#define ADAPT_MIN_BUDGET    256
+
+#if USE_FPS
+static int next_framediv(int framediv, int limit, int step)
+{
+    do {
+        framediv += step;
+    } while (framediv != limit && sv.framediv % framediv);
+
+    return framediv;
+}
+#endif
+
+static size_t average_message_size(client_t *client)
+{
+    size_t total = 0;
+    int i, count = 0;
+
+    for (i = 0; i < RATE_MESSAGES; i++) {
+        if (client->message_size[i]) {
+            total += client->message_size[i];
+            count++;
+        }
+    }
+
+    return count ? total / count : 0;
+}
+
+static void adapt_client_rate(client_t *client)
+{
+    netchan_t *netchan = client->netchan;
+    unsigned sent, acked, skipped, suppressed;
+    size_t budget, maxsize;
+    bool congested;
+
+    if (!sv_adaptive_rate->integer) {
+        // restore what client asked for
+        client->adapt_budget = 0;
+        client->adapt_time = 0;
+#if USE_FPS
+        if (client->protocol == PROTOCOL_VERSION_Q2PRO &&
+            client->framediv != client->requested_framediv)
+            SV_SetClientFramediv(client, client->requested_framediv);
+#endif
+        return;
+    }
+
+    if (client->adapt_time && svs.realtime - client->adapt_time < ADAPT_WINDOW)
+        return;
+
+    sent = client->frames_sent - client->adapt_sent;
+    acked = netchan->total_acked - client->adapt_acked;
+    skipped = netchan->total_skipped - client->adapt_skipped;
+    suppressed = client->frames_suppressed - client->adapt_suppressed;
+
+    // start new window
+    client->adapt_sent = client->frames_sent;
+    client->adapt_acked = netchan->total_acked;
+    client->adapt_skipped = netchan->total_skipped;
+    client->adapt_suppressed = client->frames_suppressed;
+    if (!client->adapt_time) {
+        client->adapt_time = svs.realtime;
+        return;
+    }
+    client->adapt_time = svs.realtime;
+
+    if (!sent && !suppressed)
+        return;
+
+    congested = skipped * 20 > acked + skipped ||
+                suppressed * 10 > sent + suppressed ||
+                (client->ping && client->ping > client->min_ping * 2 + 50);
+
+    maxsize = netchan->maxpacketlen;
+    budget = client->adapt_budget ? client->adapt_budget : maxsize;
+
+    if (congested) {
+        client->adapt_good = 0;
+#if USE_FPS
+        if (client->protocol == PROTOCOL_VERSION_Q2PRO && client->framediv < sv.framediv)
+            SV_SetClientFramediv(client, next_framediv(client->framediv, sv.framediv, 1));
+#endif
+        budget = min(budget, max(average_message_size(client), ADAPT_MIN_BUDGET));
+        client->adapt_budget = max(budget * 3 / 4, ADAPT_MIN_BUDGET);
+        return;
+    }
+
+    if (++client->adapt_good < ADAPT_GOOD_WINDOWS)
+        return;
+
+    client->adapt_good = 0;
+#if USE_FPS
+    if (client->framediv > client->requested_framediv) {
+        SV_SetClientFramediv(client, next_framediv(client->framediv, client->requested_framediv, -1));
+        return;
+    }
+#endif
+    if (client->adapt_budget) {
+        budget = budget * 5 / 4;
+        client->adapt_budget = budget < maxsize ? budget : 0;
+    }
+}
+
 /*
 =======================
 SV_SendClientMessages
@@ -923,6 +1090,8 @@ advance:
         // advance for next frame
         client->framenum++;
 
+        adapt_client_rate(client);
+
 finish:
         // clear all unreliable messages still left
         finish_frame(client);
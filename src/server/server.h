@@ -28,6 +28,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "common/cvar.h"
 #include "common/error.h"
 #include "common/files.h"
+#include "common/loadprof.h"
 #include "common/msg.h"
 #include "common/net/net.h"
 #include "common/net/chan.h"
@@ -165,6 +166,13 @@ typedef struct {
     server_entity_t entities[MAX_EDICTS];
 
     unsigned    tracecount;
+
+    // last cluster row decompressed by PF_inVIS, one per vis type
+    struct {
+        bsp_t   *bsp;
+        int     cluster;
+        byte    mask[VIS_MAX_BYTES];
+    } viscache[2];
 } server_t;
 
 #define EDICT_POOL(c, n) ((edict_t *)((byte *)(c)->pool->edicts + (c)->pool->edict_size*(n)))
@@ -191,6 +199,17 @@ typedef enum {
     cs_spawned      // client is fully in game
 } clstate_t;
 
+// compression codecs, selectable per client and per GTV stream. All of them
+// produce plain deflate data any zlib capable peer can inflate, so they only
+// trade compression ratio for server CPU time.
+typedef enum {
+    SV_CODEC_DEFLATE,   // zlib default level
+    SV_CODEC_FAST,      // fastest LZ77 matching
+    SV_CODEC_HUFFMAN,   // entropy coding only, no matching
+
+    SV_CODEC_MAX
+} sv_codec_t;
+
 #if USE_AC_SERVER
 
 typedef enum {
@@ -216,11 +235,18 @@ typedef enum {
 
 #define MAX_SOUND_PACKET   14
 
+// messages larger than MSG_TRESHOLD, shared by all clients a multicast goes to
+typedef struct {
+    unsigned            refcount;
+    uint8_t             data[1];
+} message_payload_t;
+
 typedef struct {
     list_t              entry;
     uint16_t            cursize;    // zero means sound packet
     union {
         uint8_t         data[MSG_TRESHOLD];
+        message_payload_t   *payload;   // if cursize > MSG_TRESHOLD
         struct {
             uint8_t     flags;
             uint8_t     index;
@@ -271,6 +297,7 @@ typedef struct client_s {
     unsigned        reconnected: 1;
     unsigned        nodata: 1;
     unsigned        has_zlib: 1;
+    unsigned        codec: 2;   // sv_codec_t used for this client
     unsigned        drop_hack: 1;
 #if USE_ICMP
     unsigned        unreachable: 1;
@@ -306,15 +333,27 @@ typedef struct client_s {
     // frame encoding
     client_frame_t  frames[UPDATE_BACKUP];    // updates can be delta'd from here
     unsigned        frames_sent, frames_acked, frames_nodelta;
+    size_t          frame_budget;       // entity updates over this are deferred, 0 if unlimited
+    unsigned        frames_deferred, entities_deferred;
+    byte            entity_deferred[MAX_EDICTS];    // frames each update was deferred for
     int             framenum;
 #if USE_FPS
     int             framediv;
+    int             requested_framediv; // framediv asked for by the client
 #endif
     unsigned        frameflags;
 
+    // adaptive snapshot rate, see sv_adaptive_rate
+    size_t          adapt_budget;       // frame budget chosen for this client, 0 if unlimited
+    unsigned        adapt_time;         // svs.realtime when the current window started
+    unsigned        adapt_sent, adapt_suppressed;       // frame counters at window start
+    unsigned        adapt_acked, adapt_skipped;         // netchan counters at window start
+    int             adapt_good;         // consecutive windows without congestion
+
     // rate dropping
     size_t          message_size[RATE_MESSAGES];    // used to rate drop normal packets
     int             suppress_count;                 // number of messages rate suppressed
+    unsigned        frames_suppressed;              // total number of messages rate suppressed
     unsigned        send_time, send_delta;          // used to rate drop async packets
 
     // current download
@@ -466,6 +505,7 @@ typedef struct server_static_s {
 
 #if USE_ZLIB
     z_stream        z;  // for compressing messages at once
+    sv_codec_t      z_codec;    // codec svs.z parameters are set for
 #endif
 
     unsigned        last_heartbeat;
@@ -519,6 +559,10 @@ extern cvar_t       *sv_strafejump_hack;
 #if USE_PACKETDUP
 extern cvar_t       *sv_packetdup_hack;
 #endif
+#if USE_ZLIB
+extern cvar_t       *sv_compress;
+#endif
+extern cvar_t       *sv_adaptive_rate;
 extern cvar_t       *sv_allow_map;
 #if !USE_CLIENT
 extern cvar_t       *sv_recycle;
@@ -569,6 +613,12 @@ int SV_CountClients(void);
 #if USE_ZLIB
 voidpf SV_zalloc(voidpf opaque, uInt items, uInt size);
 void SV_zfree(voidpf opaque, voidpf address);
+
+sv_codec_t SV_CodecForName(const char *name);
+const char *SV_CodecName(sv_codec_t codec);
+int SV_DeflateInit(z_streamp z, sv_codec_t codec, int windowBits, int memLevel);
+void SV_DeflateReset(sv_codec_t codec);
+void sv_codec_changed(cvar_t *self);
 #endif
 
 void sv_sec_timeout_changed(cvar_t *self);
@@ -657,6 +707,25 @@ void SV_MvdStop_f(void);
 #define SV_MvdStop_f()      (void)0
 #endif
 
+//
+// sv_replay.c
+//
+void SV_ReplayRegister(void);
+void SV_ReplayShutdown(void);
+bool SV_ReplayActive(void);
+void SV_ReplayMapSpawn(mapcmd_t *cmd);
+void SV_ReplayMapSpawned(void);
+void SV_ReplayLevelRestored(void);
+void SV_ReplayConnect(client_t *cl, const char *userinfo);
+void SV_ReplayBegin(client_t *cl);
+void SV_ReplayUserinfo(client_t *cl);
+void SV_ReplayCommand(client_t *cl, const char *s);
+void SV_ReplayMove(client_t *cl, const usercmd_t *cmd);
+void SV_ReplayDisconnect(client_t *cl);
+void SV_ReplayFrame(void);
+bool SV_ReplayTimedemo(void);
+bool SV_ReplayRunClients(void);
+
 //
 // sv_ac.c
 //
@@ -699,8 +768,14 @@ void SV_New_f(void);
 void SV_Begin_f(void);
 void SV_ExecuteClientMessage(client_t *cl);
 void SV_CloseDownload(client_t *client);
+#if USE_ZLIB
+void SV_FlushGamestateCache(void);
+#else
+#define SV_FlushGamestateCache() (void)0
+#endif
 #if USE_FPS
 void SV_AlignKeyFrames(client_t *client);
+void SV_SetClientFramediv(client_t *client, int framediv);
 #else
 #define SV_AlignKeyFrames(client) (void)0
 #endif
@@ -157,14 +157,127 @@ static void write_plain_baselines(void)
 
 #if USE_ZLIB
 
+/*
+================
+Gamestate cache
+
+Compressed gamestate is identical for every client on the same map using
+the same protocol variant and codec, so it is deflated once and shared. Uncompressed
+gamestate is still built per client (it's cheap) and compared against the
+cached copy, which keeps baselines changed by the game between connects
+from being sent stale. Cache is flushed on configstring changes.
+================
+*/
+
+#define GAMESTATE_CACHE_SIZE    4
+
+typedef struct {
+    unsigned    refcount;
+    unsigned    lastused;
+    sv_codec_t  codec;
+    size_t      rawlen;
+    size_t      complen;
+    byte        *comp;
+    byte        raw[1];
+} gamestate_t;
+
+static gamestate_t  *gamestate_cache[GAMESTATE_CACHE_SIZE];
+static unsigned     gamestate_sequence;
+
+static void release_gamestate(gamestate_t *gs)
+{
+    if (--gs->refcount == 0) {
+        Z_Free(gs);
+    }
+}
+
+void SV_FlushGamestateCache(void)
+{
+    int i;
+
+    for (i = 0; i < GAMESTATE_CACHE_SIZE; i++) {
+        if (gamestate_cache[i]) {
+            release_gamestate(gamestate_cache[i]);
+            gamestate_cache[i] = NULL;
+        }
+    }
+}
+
+static gamestate_t *find_gamestate(void)
+{
+    gamestate_t *gs;
+    int i;
+
+    for (i = 0; i < GAMESTATE_CACHE_SIZE; i++) {
+        gs = gamestate_cache[i];
+        if (gs && gs->codec == sv_client->codec &&
+            gs->rawlen == msg_write.cursize &&
+            !memcmp(gs->raw, msg_write.data, gs->rawlen)) {
+            gs->lastused = ++gamestate_sequence;
+            gs->refcount++;
+            return gs;
+        }
+    }
+
+    return NULL;
+}
+
+static gamestate_t *compress_gamestate(void)
+{
+    byte        buffer[MAX_MSGLEN];
+    gamestate_t *gs, **slot;
+    int         i;
+
+    SV_DeflateReset(sv_client->codec);
+    svs.z.next_in = msg_write.data;
+    svs.z.avail_in = (uInt)msg_write.cursize;
+    svs.z.next_out = buffer;
+    svs.z.avail_out = (uInt)sizeof(buffer);
+
+    if (deflate(&svs.z, Z_FINISH) != Z_STREAM_END) {
+        return NULL;
+    }
+
+    SV_DPrintf(0, "%s: comp: %lu into %lu\n",
+               sv_client->name, svs.z.total_in, svs.z.total_out);
+
+    gs = SV_Malloc(sizeof(*gs) + msg_write.cursize + svs.z.total_out);
+    gs->refcount = 2;   // one for the cache, one for the caller
+    gs->lastused = ++gamestate_sequence;
+    gs->codec = sv_client->codec;
+    gs->rawlen = msg_write.cursize;
+    gs->complen = svs.z.total_out;
+    gs->comp = gs->raw + gs->rawlen;
+    memcpy(gs->raw, msg_write.data, gs->rawlen);
+    memcpy(gs->comp, buffer, gs->complen);
+
+    // replace empty or least recently used slot
+    slot = &gamestate_cache[0];
+    for (i = 0; i < GAMESTATE_CACHE_SIZE; i++) {
+        if (!gamestate_cache[i]) {
+            slot = &gamestate_cache[i];
+            break;
+        }
+        if (gamestate_cache[i]->lastused < (*slot)->lastused) {
+            slot = &gamestate_cache[i];
+        }
+    }
+    if (*slot) {
+        release_gamestate(*slot);
+    }
+    *slot = gs;
+
+    return gs;
+}
+
 static void write_compressed_gamestate(void)
 {
     sizebuf_t   *buf = &sv_client->netchan->message;
     entity_packed_t  *base;
     int         i, j;
     size_t      length;
-    uint8_t     *patch;
     char        *string;
+    gamestate_t *gs;
 
     MSG_WriteByte(svc_gamestate);
 
@@ -200,28 +313,26 @@ static void write_compressed_gamestate(void)
     }
     MSG_WriteShort(0);   // end of baselines
 
-    SZ_WriteByte(buf, svc_zpacket);
-    patch = SZ_GetSpace(buf, 2);
-    SZ_WriteShort(buf, msg_write.cursize);
-
-    deflateReset(&svs.z);
-    svs.z.next_in = msg_write.data;
-    svs.z.avail_in = (uInt)msg_write.cursize;
-    svs.z.next_out = buf->data + buf->cursize;
-    svs.z.avail_out = (uInt)(buf->maxsize - buf->cursize);
+    gs = find_gamestate();
+    if (!gs) {
+        gs = compress_gamestate();
+    }
     SZ_Clear(&msg_write);
 
-    if (deflate(&svs.z, Z_FINISH) != Z_STREAM_END) {
+    if (!gs || buf->cursize + gs->complen + 5 > buf->maxsize) {
+        if (gs) {
+            release_gamestate(gs);
+        }
         SV_DropClient(sv_client, "deflate() failed on gamestate");
         return;
     }
 
-    SV_DPrintf(0, "%s: comp: %lu into %lu\n",
-               sv_client->name, svs.z.total_in, svs.z.total_out);
+    SZ_WriteByte(buf, svc_zpacket);
+    SZ_WriteShort(buf, gs->complen);
+    SZ_WriteShort(buf, gs->rawlen);
+    SZ_Write(buf, gs->comp, gs->complen);
 
-    patch[0] = svs.z.total_out & 255;
-    patch[1] = (svs.z.total_out >> 8) & 255;
-    buf->cursize += svs.z.total_out;
+    release_gamestate(gs);
 }
 
 static inline int z_flush(byte *buffer)
@@ -248,7 +359,7 @@ static inline int z_flush(byte *buffer)
 
 static inline void z_reset(byte *buffer)
 {
-    deflateReset(&svs.z);
+    SV_DeflateReset(sv_client->codec);
     svs.z.next_out = buffer;
     svs.z.avail_out = (uInt)(sv_client->netchan->maxpacketlen - 5);
 }
@@ -526,6 +637,8 @@ void SV_Begin_f(void)
 
     stuff_cmds(&sv_cmdlist_begin);
 
+    SV_ReplayBegin(sv_client);
+
     // call the game begin function
     ge->ClientBegin(sv_player);
 
@@ -1002,6 +1115,7 @@ static void SV_ExecuteUserCommand(const char *s)
         sv_client->lastactivity = svs.realtime;
     }
 
+    SV_ReplayCommand(sv_client, s);
     ge->ClientCommand(sv_player);
 }
 
@@ -1043,6 +1157,7 @@ static inline void SV_ClientThink(usercmd_t *cmd)
         sv_client->lastactivity = svs.realtime;
     }
 
+    SV_ReplayMove(sv_client, cmd);
     ge->ClientThink(sv_player, cmd);
 }
 
@@ -1379,9 +1494,37 @@ void SV_AlignKeyFrames(client_t *client)
     client->framenum = newnum;
 }
 
+/*
+==================
+SV_SetClientFramediv
+
+Changes the rate at which frames are sent to the client and tells
+the client about the new rate.
+==================
+*/
+void SV_SetClientFramediv(client_t *client, int framediv)
+{
+    int framerate = sv.framerate / framediv;
+
+    Com_DPrintf("[%d] client div=%d, server div=%d, rate=%d\n",
+                sv.framenum, framediv, sv.framediv, framerate);
+
+    client->framediv = framediv;
+
+    SV_AlignKeyFrames(client);
+
+    // save for status inspection
+    client->settings[CLS_FPS] = framerate;
+
+    MSG_WriteByte(svc_setting);
+    MSG_WriteLong(SVS_FPS);
+    MSG_WriteLong(framerate);
+    SV_ClientAddMessage(client, MSG_RELIABLE | MSG_CLEAR);
+}
+
 static void set_client_fps(int value)
 {
-    int framediv, framerate;
+    int framediv;
 
     // 0 means highest
     if (!value)
@@ -1392,22 +1535,11 @@ static void set_client_fps(int value)
     clamp(framediv, 1, MAX_FRAMEDIV);
 
     framediv = sv.framediv / Q_gcd(sv.framediv, framediv);
-    framerate = sv.framerate / framediv;
 
-    Com_DPrintf("[%d] client div=%d, server div=%d, rate=%d\n",
-                sv.framenum, framediv, sv.framediv, framerate);
-
-    sv_client->framediv = framediv;
-
-    SV_AlignKeyFrames(sv_client);
-
-    // save for status inspection
-    sv_client->settings[CLS_FPS] = framerate;
+    // adaptive rate never goes above what client asked for
+    sv_client->requested_framediv = framediv;
 
-    MSG_WriteByte(svc_setting);
-    MSG_WriteLong(SVS_FPS);
-    MSG_WriteLong(framerate);
-    SV_ClientAddMessage(sv_client, MSG_RELIABLE | MSG_CLEAR);
+    SV_SetClientFramediv(sv_client, framediv);
 }
 #endif
 
@@ -0,0 +1,347 @@
+#include "speedrun/splits.h"
+#include "common/cmd.h"
+#include "common/common.h"
+#include "common/files.h"
+#include "timer_helper.h"
+
+
+#define MAX_SPLITS 64
+
+struct SpeedrunSplitRecord
+{
+	char map[MAX_QPATH];
+	uint64_t segment;       // level game time in microseconds
+	uint64_t total;         // run game time at the end of the level
+	uint64_t best_segment;  // only kept for stored records
+};
+
+// Splits of the run in progress.
+static struct SpeedrunSplitRecord run_splits[MAX_SPLITS];
+static int num_run_splits = 0;
+
+// Personal best run and best segments, loaded from speedrun/<map>.txt where
+// <map> is the first level of the run. A zero total means the best segment
+// is known, but no finished run has reached this split yet.
+static struct SpeedrunSplitRecord stored_splits[MAX_SPLITS];
+static int num_stored_splits = 0;
+
+static char run_name[MAX_QPATH];
+static char level_name[MAX_QPATH];
+
+// HUD delta of the last split, formatted once when the split happens.
+static char split_delta_string[SPEEDRUN_DELTA_LENGTH];
+static bool split_delta_valid = false;
+static bool split_delta_behind = false;
+
+// HUD delta while behind the personal best on the current level, formatted
+// only when the displayed tenth of a second changes.
+static char live_delta_string[SPEEDRUN_DELTA_LENGTH];
+static uint64_t live_delta_tenths = UINT64_MAX;
+
+static void FormatDelta(char delta_string[static SPEEDRUN_DELTA_LENGTH],
+                        uint64_t run_time, uint64_t pb_time, int accuracy)
+{
+	if (run_time > pb_time)
+	{
+		delta_string[0] = '+';
+		SpeedrunGetTimeString((run_time - pb_time) / 1000, accuracy,
+		                      delta_string + 1);
+	}
+	else
+	{
+		delta_string[0] = '-';
+		SpeedrunGetTimeString((pb_time - run_time) / 1000, accuracy,
+		                      delta_string + 1);
+	}
+}
+
+// Returns the stored record to compare split 'index' against, or NULL if the
+// run took a different route.
+static struct SpeedrunSplitRecord *ComparedSplit(int index, const char *map)
+{
+	if (index >= num_stored_splits)
+	{
+		return NULL;
+	}
+	if (Q_stricmp(stored_splits[index].map, map))
+	{
+		return NULL;
+	}
+	return &stored_splits[index];
+}
+
+// Returns the total time of the personal best run, or 0 if none has been
+// finished. Splits appended by runs that went further only track best
+// segments and have no total.
+static uint64_t PersonalBestTotal(void)
+{
+	for (int i = num_stored_splits - 1; i >= 0; i--)
+	{
+		if (stored_splits[i].total > 0)
+		{
+			return stored_splits[i].total;
+		}
+	}
+	return 0;
+}
+
+static void LoadSplits(void)
+{
+	char path[MAX_QPATH];
+	char *data, *line, *next;
+	struct SpeedrunSplitRecord *record;
+
+	num_stored_splits = 0;
+
+	if (Q_concat(path, sizeof(path), "speedrun/", run_name, ".txt", NULL)
+	        >= sizeof(path))
+	{
+		return;
+	}
+	if (FS_LoadFile(path, (void **)&data) < 0)
+	{
+		return;
+	}
+
+	for (line = data; line && num_stored_splits < MAX_SPLITS; line = next)
+	{
+		next = strchr(line, '\n');
+		if (next)
+		{
+			*next++ = 0;
+		}
+
+		record = &stored_splits[num_stored_splits];
+		if (sscanf(line, "%63s %"SCNu64" %"SCNu64" %"SCNu64, record->map,
+		           &record->segment, &record->total,
+		           &record->best_segment) == 4)
+		{
+			num_stored_splits++;
+		}
+	}
+
+	FS_FreeFile(data);
+}
+
+static void SaveSplits(void)
+{
+	char path[MAX_OSPATH];
+	qhandle_t f;
+
+	f = FS_EasyOpenFile(path, sizeof(path), FS_MODE_WRITE | FS_FLAG_TEXT,
+	                    "speedrun/", run_name, ".txt");
+	if (!f)
+	{
+		return;
+	}
+
+	FS_FPrintf(f, "// map, pb segment, pb total, best segment (usec)\n");
+	for (int i = 0; i < num_stored_splits; i++)
+	{
+		const struct SpeedrunSplitRecord *record = &stored_splits[i];
+		FS_FPrintf(f, "%s %"PRIu64" %"PRIu64" %"PRIu64"\n", record->map,
+		           record->segment, record->total, record->best_segment);
+	}
+
+	if (FS_FCloseFile(f))
+	{
+		Com_EPrintf("Error writing %s\n", path);
+	}
+}
+
+void SpeedrunSplitsReset()
+{
+	num_run_splits = 0;
+	num_stored_splits = 0;
+	run_name[0] = 0;
+	level_name[0] = 0;
+	split_delta_valid = false;
+	live_delta_tenths = UINT64_MAX;
+}
+
+void SpeedrunSplitsStartLevel(const char *mapname)
+{
+	if (!run_name[0])
+	{
+		Q_strlcpy(run_name, mapname, sizeof(run_name));
+		LoadSplits();
+	}
+
+	Q_strlcpy(level_name, mapname, sizeof(level_name));
+	live_delta_tenths = UINT64_MAX;
+}
+
+void SpeedrunSplitsLevelFinished(uint64_t segment, uint64_t total)
+{
+	// only the first finish of each level counts
+	if (!level_name[0] || num_run_splits == MAX_SPLITS)
+	{
+		return;
+	}
+
+	const int index = num_run_splits++;
+	struct SpeedrunSplitRecord *split = &run_splits[index];
+	Q_strlcpy(split->map, level_name, sizeof(split->map));
+	split->segment = segment;
+	split->total = total;
+	split->best_segment = segment;
+	level_name[0] = 0;
+
+	struct SpeedrunSplitRecord *compared = ComparedSplit(index, split->map);
+	if (!compared && index == num_stored_splits)
+	{
+		// first time this far on this route, start tracking best segments
+		compared = &stored_splits[num_stored_splits++];
+		memset(compared, 0, sizeof(*compared));
+		Q_strlcpy(compared->map, split->map, sizeof(compared->map));
+	}
+	if (!compared)
+	{
+		split_delta_valid = false;
+		return;
+	}
+
+	split_delta_valid = compared->total > 0;
+	if (split_delta_valid)
+	{
+		FormatDelta(split_delta_string, total, compared->total, 2);
+		split_delta_behind = total > compared->total;
+	}
+
+	if (!compared->best_segment || segment < compared->best_segment)
+	{
+		compared->best_segment = segment;
+		SaveSplits();
+	}
+}
+
+void SpeedrunSplitsRunFinished()
+{
+	if (!num_run_splits)
+	{
+		return;
+	}
+
+	// keep the personal best unless this run was faster, whatever route
+	// either of them took
+	const uint64_t best_total = PersonalBestTotal();
+	if (best_total > 0 && run_splits[num_run_splits - 1].total >= best_total)
+	{
+		return;
+	}
+
+	for (int i = 0; i < num_run_splits; i++)
+	{
+		struct SpeedrunSplitRecord *stored = &stored_splits[i];
+		const struct SpeedrunSplitRecord *split = &run_splits[i];
+		uint64_t best = split->segment;
+		if (ComparedSplit(i, split->map) && stored->best_segment &&
+		        stored->best_segment < best)
+		{
+			best = stored->best_segment;
+		}
+		*stored = *split;
+		stored->best_segment = best;
+	}
+	num_stored_splits = num_run_splits;
+
+	SaveSplits();
+	Com_Printf("New personal best for %s.\n", run_name);
+}
+
+const char *SpeedrunGetSplitDelta(bool *behind)
+{
+	const struct SpeedrunSplitRecord *compared = NULL;
+	if (level_name[0])
+	{
+		compared = ComparedSplit(num_run_splits, level_name);
+	}
+
+	if (compared && compared->total > 0)
+	{
+		const uint64_t total = SpeedrunGetTotalTime();
+		if (total > compared->total)
+		{
+			const uint64_t tenths = (total - compared->total) / 100000;
+			if (tenths != live_delta_tenths)
+			{
+				live_delta_tenths = tenths;
+				FormatDelta(live_delta_string, total, compared->total, 1);
+			}
+			*behind = true;
+			return live_delta_string;
+		}
+	}
+
+	if (!split_delta_valid)
+	{
+		return NULL;
+	}
+
+	*behind = split_delta_behind;
+	return split_delta_string;
+}
+
+static void SpeedrunSplits_f(void)
+{
+	char segment[SPEEDRUN_TIME_LENGTH];
+	char total[SPEEDRUN_TIME_LENGTH];
+	char delta[SPEEDRUN_DELTA_LENGTH];
+	char best[SPEEDRUN_TIME_LENGTH];
+	uint64_t sum_of_best = 0;
+
+	if (!run_name[0])
+	{
+		Com_Printf("No speedrun in progress.\n");
+		return;
+	}
+
+	Com_Printf("Splits for %s\n"
+	           "map              segment        total        delta         best\n"
+	           "---------------- ------------ ------------ ------------- ------------\n",
+	           run_name);
+
+	const int count = max(num_run_splits, num_stored_splits);
+	for (int i = 0; i < count; i++)
+	{
+		const struct SpeedrunSplitRecord *split =
+			i < num_run_splits ? &run_splits[i] : NULL;
+		const struct SpeedrunSplitRecord *stored =
+			i < num_stored_splits ? &stored_splits[i] : NULL;
+		if (split && stored && Q_stricmp(split->map, stored->map))
+		{
+			stored = NULL;
+		}
+
+		strcpy(segment, "-");
+		strcpy(total, "-");
+		strcpy(delta, "-");
+		strcpy(best, "-");
+		if (split)
+		{
+			SpeedrunGetTimeString(split->segment / 1000, 3, segment);
+			SpeedrunGetTimeString(split->total / 1000, 3, total);
+		}
+		if (split && stored && stored->total)
+		{
+			FormatDelta(delta, split->total, stored->total, 3);
+		}
+		if (stored && stored->best_segment)
+		{
+			SpeedrunGetTimeString(stored->best_segment / 1000, 3, best);
+			sum_of_best += stored->best_segment;
+		}
+
+		Com_Printf("%-16s %12s %12s %13s %12s\n",
+		           split ? split->map : stored->map, segment, total, delta,
+		           best);
+	}
+
+	SpeedrunGetTimeString(sum_of_best / 1000, 3, best);
+	Com_Printf("\nSum of best segments: %s\n", best);
+}
+
+void SpeedrunSplitsInit()
+{
+	Cmd_AddCommand("speedrun_splits", SpeedrunSplits_f);
+}
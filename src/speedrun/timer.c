@@ -1,96 +1,229 @@
 #include "speedrun/timer.h"
+#include "speedrun/splits.h"
+#include "common/cmd.h"
+#include "common/common.h"
 #include "system/system.h"
 #include "timer_helper.h"
 
 
-int last_timestamp = 0;
-int stored_total_time = 0;
-int stored_level_time = 0;
-volatile int current_total_time = 0;
-volatile int current_level_time = 0;
-int pause_counter = 1;
+struct SpeedrunSplit
+{
+	uint64_t game;  // simulated frame time
+	uint64_t real;  // wall clock time while running
+	uint64_t load;  // wall clock time spent inside any load phase
+	uint64_t phases[SPEEDRUN_LOAD_MAX];
+};
+
+static const char *const load_phase_names[SPEEDRUN_LOAD_MAX] = {
+	"map",
+	"precache",
+	"savegame",
+	"registration"
+};
+
+static struct SpeedrunSplit total_split;
+static struct SpeedrunSplit level_split;
+
+// All timestamps are Sys_Microseconds. Real and load time are accumulated
+// lazily from 'last_timestamp' whenever the timer state changes or is read,
+// so nothing needs to be sampled per Qcommon_Frame.
+static uint64_t last_timestamp = 0;
 
-bool IsPaused() {
+// Wall clock and load time since the last timed game frame. Game time is
+// advanced in whole frames; the display interpolates with the part of
+// 'frame_real' that was not spent loading.
+static uint64_t frame_real = 0;
+static uint64_t frame_load = 0;
+
+static unsigned active_phases = 0;
+static int pause_counter = 1;
+
+static bool IsPaused(void)
+{
 	return pause_counter > 0;
 }
 
-void SpeedrunResetTimer()
+static void AdvanceSplit(struct SpeedrunSplit *split, uint64_t delta)
 {
-	last_timestamp = 0;
-	stored_total_time = 0;
-	stored_level_time = 0;
-	current_total_time = 0;
-	current_level_time = 0;
-	pause_counter = 1;
+	split->real += delta;
+	if (!active_phases)
+	{
+		return;
+	}
+
+	split->load += delta;
+	for (int i = 0; i < SPEEDRUN_LOAD_MAX; i++)
+	{
+		if (active_phases & (1U << i))
+		{
+			split->phases[i] += delta;
+		}
+	}
 }
 
-void SpeedrunUpdateTimer()
+static void SpeedrunAdvance(void)
 {
+	uint64_t const current_timestamp = Sys_Microseconds();
+	uint64_t const delta = current_timestamp - last_timestamp;
+
+	last_timestamp = current_timestamp;
 	if (IsPaused())
 	{
 		return;
 	}
 
-	int const current_timestamp = Sys_Milliseconds();
-	current_total_time = stored_total_time + (current_timestamp - last_timestamp);
-	current_level_time = stored_level_time + (current_timestamp - last_timestamp);
+	AdvanceSplit(&total_split, delta);
+	AdvanceSplit(&level_split, delta);
+	frame_real += delta;
+	if (active_phases)
+	{
+		frame_load += delta;
+	}
+}
+
+static uint64_t FramePartial(void)
+{
+	return frame_real - frame_load;
+}
+
+static void FoldFramePartial(void)
+{
+	uint64_t const partial = FramePartial();
+	total_split.game += partial;
+	level_split.game += partial;
+	frame_real = 0;
+	frame_load = 0;
+}
+
+void SpeedrunResetTimer()
+{
+	memset(&total_split, 0, sizeof(total_split));
+	memset(&level_split, 0, sizeof(level_split));
+	last_timestamp = Sys_Microseconds();
+	frame_real = 0;
+	frame_load = 0;
+	active_phases = 0;
+	pause_counter = 1;
+	SpeedrunSplitsReset();
 }
 
 void SpeedrunUnpauseTimer()
 {
+	SpeedrunAdvance();
 	if (IsPaused())
 	{
 		pause_counter -= 1;
-		last_timestamp = Sys_Milliseconds();
 	}
 }
 
-void SpeedrunStoreCurrentTime()
-{
-	int const current_timestamp = Sys_Milliseconds();
-	stored_total_time += (current_timestamp - last_timestamp);
-	stored_level_time += (current_timestamp - last_timestamp);
-	current_total_time = stored_total_time;
-	current_level_time = stored_level_time;
-	last_timestamp = current_timestamp;
-}
-
 int SpeedrunPauseTimer()
 {
+	SpeedrunAdvance();
 	pause_counter += 1;
 	return (pause_counter > 1);
 }
 
 void SpeedrunLevelFinished()
 {
+	SpeedrunAdvance();
 	if (!IsPaused())
 	{
-		SpeedrunStoreCurrentTime();
+		FoldFramePartial();
+		SpeedrunSplitsLevelFinished(level_split.game, total_split.game);
 	}
 
-	stored_level_time = 0;
+	memset(&level_split, 0, sizeof(level_split));
+}
+
+void SpeedrunBeginLoad(speedrun_load_t phase)
+{
+	SpeedrunAdvance();
+	active_phases |= 1U << phase;
+}
+
+void SpeedrunEndLoad(speedrun_load_t phase)
+{
+	SpeedrunAdvance();
+	active_phases &= ~(1U << phase);
+}
+
+void SpeedrunAbortLoad()
+{
+	SpeedrunAdvance();
+	active_phases = 0;
+}
+
+static uint64_t CurrentGameTime(const struct SpeedrunSplit *split)
+{
+	SpeedrunAdvance();
+	return split->game + FramePartial();
+}
+
+uint64_t SpeedrunGetTotalTime()
+{
+	return CurrentGameTime(&total_split);
+}
+
+uint64_t SpeedrunGetLevelTime()
+{
+	return CurrentGameTime(&level_split);
 }
 
 void SpeedrunGetTotalTimeString(
 		int accuracy, char time_string[static SPEEDRUN_TIME_LENGTH])
 {
-	SpeedrunGetTimeString(current_total_time, accuracy, time_string);
+	SpeedrunGetTimeString(CurrentGameTime(&total_split) / 1000, accuracy,
+	                      time_string);
 }
 
 void SpeedrunGetLevelTimeString(
 		int accuracy, char time_string[static SPEEDRUN_TIME_LENGTH])
 {
-	SpeedrunGetTimeString(current_level_time, accuracy, time_string);
+	SpeedrunGetTimeString(CurrentGameTime(&level_split) / 1000, accuracy,
+	                      time_string);
 }
 
 void SpeedrunTimerAddMilliseconds(int milliseconds)
 {
+	SpeedrunAdvance();
 	if (IsPaused())
 	{
 		return;
 	}
-	
-	stored_total_time += milliseconds;
-	stored_level_time += milliseconds;
-	last_timestamp = Sys_Milliseconds();
+
+	// a timed frame replaces the wall clock time elapsed since the last one
+	total_split.game += milliseconds * 1000ULL;
+	level_split.game += milliseconds * 1000ULL;
+	frame_real = 0;
+	frame_load = 0;
+}
+
+static void PrintSplit(const char *name, const struct SpeedrunSplit *split)
+{
+	Com_Printf("%s:\n", name);
+	Com_Printf("  game        %12.3f\n", split->game * 1e-3);
+	Com_Printf("  real        %12.3f\n", split->real * 1e-3);
+	Com_Printf("  load        %12.3f\n", split->load * 1e-3);
+	Com_Printf("  real - load %12.3f\n", (split->real - split->load) * 1e-3);
+	for (int i = 0; i < SPEEDRUN_LOAD_MAX; i++)
+	{
+		Com_Printf("    %-14s%12.3f\n", load_phase_names[i],
+		           split->phases[i] * 1e-3);
+	}
+}
+
+static void SpeedrunTimes_f(void)
+{
+	SpeedrunAdvance();
+	Com_Printf("Speedrun times in msec (%s)\n",
+	           IsPaused() ? "paused" : "running");
+	PrintSplit("Total", &total_split);
+	PrintSplit("Level", &level_split);
+}
+
+void SpeedrunInitTimer()
+{
+	last_timestamp = Sys_Microseconds();
+	Cmd_AddCommand("speedrun_times", SpeedrunTimes_f);
+	SpeedrunSplitsInit();
 }
@@ -1,6 +1,4 @@
 #include "timer_helper.h"
-#include <math.h>
-#include <stdio.h>
 #include <string.h>
 
 
@@ -21,6 +19,16 @@ struct SpeedrunTime GetSpeedrunTime(int milliseconds)
 	return t;
 }
 
+static char *PutDigits(char *p, int value, int digits)
+{
+	for (int i = digits - 1; i >= 0; i -= 1)
+	{
+		p[i] = '0' + value % 10;
+		value /= 10;
+	}
+	return p + digits;
+}
+
 void SpeedrunGetTimeString(const int milliseconds, int accuracy,
                            char time_string[static SPEEDRUN_TIME_LENGTH])
 {
@@ -38,27 +46,20 @@ void SpeedrunGetTimeString(const int milliseconds, int accuracy,
 	char *p = time_string;
 	if (t.hours > 0)
 	{
-		const char *format = (t.hours >= 10 ? "%02i:" : "%i:");
-		p += sprintf(p, format, t.hours);
-	}
-	if (t.hours == 0 && t.minutes < 10)
-	{
-		p += sprintf(p, "%i:", t.minutes);
-	}
-	else
-	{
-		p += sprintf(p, "%02i:", t.minutes);
+		p = PutDigits(p, t.hours, t.hours >= 10 ? 2 : 1);
+		*p++ = ':';
 	}
-	p += sprintf(p, "%02i", t.seconds);
+	p = PutDigits(p, t.minutes, (t.hours == 0 && t.minutes < 10) ? 1 : 2);
+	*p++ = ':';
+	p = PutDigits(p, t.seconds, 2);
 
 	if (accuracy > 0)
 	{
+		static const int DIVISORS[] = { 1000, 100, 10, 1 };
 		const int MAX_ACCURACY = 3;
 		accuracy = min(MAX_ACCURACY, accuracy);
 
-		char format[6] = ".%00i";
-		format[3] += accuracy;
-		const int divisor = pow(10, MAX_ACCURACY - accuracy);
-		sprintf(p, format, t.milliseconds / divisor);
+		*p++ = '.';
+		PutDigits(p, t.milliseconds / DIVISORS[accuracy], accuracy);
 	}
 }
@@ -12,5 +12,3 @@ struct SpeedrunTime
 };
 
 struct SpeedrunTime GetSpeedrunTime(int milliseconds);
-void SpeedrunGetTimeString(int milliseconds, int accuracy,
-                           char time_string[static SPEEDRUN_TIME_LENGTH]);
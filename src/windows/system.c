@@ -762,6 +762,19 @@ unsigned Sys_Milliseconds(void)
     return tm.QuadPart * 1000ULL / timer_freq.QuadPart;
 }
 
+uint64_t Sys_Microseconds(void)
+{
+    LARGE_INTEGER tm;
+    uint64_t sec, rem;
+
+    QueryPerformanceCounter(&tm);
+
+    // split to avoid overflow with high frequency counters
+    sec = tm.QuadPart / timer_freq.QuadPart;
+    rem = tm.QuadPart % timer_freq.QuadPart;
+    return sec * 1000000ULL + rem * 1000000ULL / timer_freq.QuadPart;
+}
+
 void Sys_AddDefaultConfig(void)
 {
 }
@@ -184,6 +184,7 @@ void InitGame (void)
 
 	// dm map list
 	sv_maplist = gi.cvar ("sv_maplist", "", 0);
+	g_seed = gi.cvar ("g_seed", "0", 0);
 
 	// obtain server features
 	sv_features = gi.cvar("sv_features", NULL, 0);
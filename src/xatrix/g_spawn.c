@@ -362,6 +362,85 @@ static const spawn_field_t temp_fields[] = {
 	{ NULL }
 };
 
+// spawn functions and items merged into a single table sorted by
+// classname, built on first use
+typedef struct
+{
+	const char			*name;
+	int					order;
+	gitem_t				*item;
+	const spawn_func_t	*func;
+} spawn_index_t;
+
+static spawn_index_t	spawn_index[MAX_ITEMS + q_countof(spawn_funcs)];
+static int				num_spawn_index;
+
+static int ED_SpawnIndexCmp (const void *p1, const void *p2)
+{
+	const spawn_index_t	*a = p1;
+	const spawn_index_t	*b = p2;
+	int		ret = strcmp (a->name, b->name);
+
+	// items take precedence over spawn functions, earlier entries over later
+	return ret ? ret : a->order - b->order;
+}
+
+static void ED_InitSpawnIndex (void)
+{
+	const spawn_func_t	*s;
+	gitem_t	*item;
+	int		i, n;
+
+	n = 0;
+	for (i=0,item=itemlist ; i<game.num_items && i<MAX_ITEMS ; i++,item++)
+	{
+		if (!item->classname)
+			continue;
+		spawn_index[n].name = item->classname;
+		spawn_index[n].order = n;
+		spawn_index[n].item = item;
+		spawn_index[n].func = NULL;
+		n++;
+	}
+
+	for (s=spawn_funcs ; s->name ; s++)
+	{
+		spawn_index[n].name = s->name;
+		spawn_index[n].order = n;
+		spawn_index[n].item = NULL;
+		spawn_index[n].func = s;
+		n++;
+	}
+
+	qsort (spawn_index, n, sizeof(spawn_index[0]), ED_SpawnIndexCmp);
+	num_spawn_index = n;
+}
+
+static const spawn_index_t *ED_FindSpawn (const char *classname)
+{
+	int		lo, hi, mid;
+
+	if (!num_spawn_index)
+		ED_InitSpawnIndex ();
+
+	// find the first entry not less than classname
+	lo = 0;
+	hi = num_spawn_index;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (strcmp (spawn_index[mid].name, classname) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < num_spawn_index && !strcmp (spawn_index[lo].name, classname))
+		return &spawn_index[lo];
+
+	return NULL;
+}
+
 /*
 ===============
 ED_CallSpawn
@@ -371,9 +450,7 @@ Finds the spawn function for the entity and calls it
 */
 void ED_CallSpawn (edict_t *ent)
 {
-	const spawn_func_t	*s;
-	gitem_t	*item;
-	int		i;
+	const spawn_index_t	*s;
 
 	if (!ent->classname)
 	{
@@ -381,28 +458,18 @@ void ED_CallSpawn (edict_t *ent)
 		return;
 	}
 
-	// check item spawn functions
-	for (i=0,item=itemlist ; i<game.num_items ; i++,item++)
+	s = ED_FindSpawn (ent->classname);
+	if (!s)
 	{
-		if (!item->classname)
-			continue;
-		if (!strcmp(item->classname, ent->classname))
-		{	// found it
-			SpawnItem (ent, item);
-			return;
-		}
+		gi.dprintf ("%s doesn't have a spawn function\n", ent->classname);
+		return;
 	}
 
-	// check normal spawn functions
-	for (s=spawn_funcs ; s->name ; s++)
-	{
-		if (!strcmp(s->name, ent->classname))
-		{	// found it
-			s->spawn (ent);
-			return;
-		}
-	}
-	gi.dprintf ("%s doesn't have a spawn function\n", ent->classname);
+	// found it
+	if (s->item)
+		SpawnItem (ent, s->item);
+	else
+		s->func->spawn (ent);
 }
 
 /*
@@ -629,6 +696,10 @@ void SpawnEntities(const char *mapname, const char *entities, const char *spawnp
 	memset (&level, 0, sizeof(level));
 	memset (g_edicts, 0, game.maxentities * sizeof (g_edicts[0]));
 
+	// fixed seed makes the level reproducible from recorded user commands
+	if (g_seed->integer)
+		Q_srand (g_seed->integer);
+
 	Q_strlcpy (level.mapname, mapname, sizeof(level.mapname));
 	Q_strlcpy (game.spawnpoint, spawnpoint, sizeof(game.spawnpoint));
 